@@ -0,0 +1,347 @@
+#pragma once
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/NodeVisitor>
+#include <osg/TriangleIndexFunctor>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include <vector>
+
+//
+// StaticBatcher
+// -------------
+// Merges the static geometry under a node into a few large VBO-backed
+// geometries, so thousands of small drawables cost a handful of draw
+// calls and cull items.
+//
+// Geometries are merged when they share state (their own and their
+// Geode's StateSet) and attribute layout (vertices, optional normals,
+// colours and texture unit 0). Static transforms are baked into the
+// vertices. Everything is turned into indexed triangles.
+//
+// Space is cut into cubes of chunkSize; each cube becomes its own Geode,
+// so frustum culling still drops what is off screen. A batch is also
+// split when it reaches maxVertices.
+//
+// Anything it cannot merge is kept as is (with its accumulated transform):
+// drawables with other arrays, lines or points, callbacks or DYNAMIC data
+// variance, and nodes whose type carries behaviour (Switch, LOD, Billboard,
+// Camera, ...).
+//
+// Usage:
+//   StaticBatcher batcher(50.0f);
+//   osg::ref_ptr<osg::Node> batched = batcher.run(scene);
+//
+class StaticBatcher : public osg::NodeVisitor
+{
+public:
+    explicit StaticBatcher(float chunkSize = 50.0f, unsigned int maxVertices = 65536)
+        : osg::NodeVisitor(TRAVERSE_ALL_CHILDREN), _chunkSize(chunkSize), _maxVertices(maxVertices) {}
+
+    // Returns the batched replacement of node; node itself is not modified
+    osg::ref_ptr<osg::Node> run(osg::Node *node)
+    {
+        _batches.clear();
+        _chunks.clear();
+        _matrices.assign(1, osg::Matrix::identity());
+        _outputs.assign(1, new osg::Group);
+        _inputDrawables = _mergedDrawables = _outputGeometries = 0;
+
+        osg::ref_ptr<osg::Group> root = _outputs.front();
+        node->accept(*this);
+        flush();
+        _outputs.clear();
+        return root;
+    }
+
+    unsigned int inputDrawables() const { return _inputDrawables; }
+    unsigned int mergedDrawables() const { return _mergedDrawables; }
+    unsigned int outputGeometries() const { return _outputGeometries; }
+    unsigned int chunks() const { return static_cast<unsigned int>(_chunks.size()); }
+
+    void apply(osg::Node &node) override { keep(node); }
+
+    void apply(osg::Group &group) override
+    {
+        if (std::strcmp(group.className(), "Group") != 0 || !isStatic(group))
+        {
+            keep(group);
+            return;
+        }
+        enter(group.getStateSet());
+        traverse(group);
+        leave(group.getStateSet());
+    }
+
+    void apply(osg::Transform &transform) override
+    {
+        const bool plain = std::strcmp(transform.className(), "MatrixTransform") == 0 ||
+                           std::strcmp(transform.className(), "PositionAttitudeTransform") == 0;
+        if (!plain || transform.getReferenceFrame() != osg::Transform::RELATIVE_RF || !isStatic(transform))
+        {
+            keep(transform);
+            return;
+        }
+        osg::Matrix m = _matrices.back();
+        transform.computeLocalToWorldMatrix(m, this);
+        _matrices.push_back(m);
+        enter(transform.getStateSet());
+        traverse(transform);
+        leave(transform.getStateSet());
+        _matrices.pop_back();
+    }
+
+    void apply(osg::Geode &geode) override
+    {
+        if (std::strcmp(geode.className(), "Geode") != 0 || !isStatic(geode))
+        {
+            keep(geode);
+            return;
+        }
+        for (unsigned int i = 0; i < geode.getNumDrawables(); ++i)
+        {
+            osg::Drawable *drawable = geode.getDrawable(i);
+            ++_inputDrawables;
+            osg::Geometry *geometry = drawable->asGeometry();
+            if (geometry && mergeable(*geometry))
+            {
+                merge(*geometry, geode.getStateSet());
+                ++_mergedDrawables;
+            }
+            else
+            {
+                osg::ref_ptr<osg::Geode> single = new osg::Geode;
+                single->setStateSet(geode.getStateSet());
+                single->addDrawable(drawable);
+                keep(*single);
+            }
+        }
+    }
+
+private:
+    enum Layout
+    {
+        NORMALS = 1,
+        COLORS = 2,
+        TEXCOORDS = 4
+    };
+
+    // One merged geometry being filled
+    struct Batch
+    {
+        osg::ref_ptr<osg::Geometry> geometry;
+        osg::ref_ptr<osg::Vec3Array> vertices, normals;
+        osg::ref_ptr<osg::Vec4Array> colors;
+        osg::ref_ptr<osg::Vec2Array> texcoords;
+        osg::ref_ptr<osg::DrawElementsUInt> triangles;
+    };
+
+    // (output group, geode state, chunk x, y, z): one Geode
+    using ChunkKey = std::tuple<osg::Group *, osg::StateSet *, int, int, int>;
+    // chunk + drawable state + layout: one open Batch
+    using BatchKey = std::tuple<ChunkKey, osg::StateSet *, int>;
+
+    struct TriangleCollector
+    {
+        std::vector<unsigned int> *indices;
+        void operator()(unsigned int a, unsigned int b, unsigned int c)
+        {
+            indices->push_back(a);
+            indices->push_back(b);
+            indices->push_back(c);
+        }
+    };
+
+    static bool isStatic(const osg::Node &node)
+    {
+        return !node.getUpdateCallback() && !node.getEventCallback() && !node.getCullCallback() &&
+               node.getDataVariance() != osg::Object::DYNAMIC;
+    }
+
+    static bool mergeable(const osg::Geometry &g)
+    {
+        if (g.getUpdateCallback() || g.getCullCallback() || g.getDrawCallback() ||
+            g.getDataVariance() == osg::Object::DYNAMIC)
+            return false;
+        if (!dynamic_cast<const osg::Vec3Array *>(g.getVertexArray()) || g.getNumTexCoordArrays() > 1 ||
+            g.getNumVertexAttribArrays() > 0 || g.getSecondaryColorArray() || g.getFogCoordArray())
+            return false;
+
+        const unsigned int n = g.getVertexArray()->getNumElements();
+        auto binding = [n](const osg::Array *a)
+        {
+            return !a || a->getBinding() == osg::Array::BIND_OVERALL ||
+                   (a->getBinding() == osg::Array::BIND_PER_VERTEX && a->getNumElements() >= n);
+        };
+        if (g.getNormalArray() && !dynamic_cast<const osg::Vec3Array *>(g.getNormalArray()))
+            return false;
+        if (g.getColorArray() && !dynamic_cast<const osg::Vec4Array *>(g.getColorArray()))
+            return false;
+        const osg::Array *tex = g.getNumTexCoordArrays() ? g.getTexCoordArray(0) : nullptr;
+        if (tex && (!dynamic_cast<const osg::Vec2Array *>(tex) || tex->getNumElements() < n))
+            return false;
+        if (!binding(g.getNormalArray()) || !binding(g.getColorArray()))
+            return false;
+
+        for (unsigned int i = 0; i < g.getNumPrimitiveSets(); ++i)
+        {
+            switch (g.getPrimitiveSet(i)->getMode())
+            {
+            case GL_TRIANGLES:
+            case GL_TRIANGLE_STRIP:
+            case GL_TRIANGLE_FAN:
+            case GL_QUADS:
+            case GL_QUAD_STRIP:
+            case GL_POLYGON:
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void merge(const osg::Geometry &g, osg::StateSet *geodeState)
+    {
+        const osg::Matrix &m = _matrices.back();
+        const osg::Vec3Array &v = *static_cast<const osg::Vec3Array *>(g.getVertexArray());
+        const osg::Vec3Array *n = static_cast<const osg::Vec3Array *>(g.getNormalArray());
+        const osg::Vec4Array *c = static_cast<const osg::Vec4Array *>(g.getColorArray());
+        const osg::Vec2Array *t = g.getNumTexCoordArrays() ? static_cast<const osg::Vec2Array *>(g.getTexCoordArray(0)) : nullptr;
+        const int layout = (n ? NORMALS : 0) | (c ? COLORS : 0) | (t ? TEXCOORDS : 0);
+
+        _indices.clear();
+        osg::TriangleIndexFunctor<TriangleCollector> collect;
+        collect.indices = &_indices;
+        g.accept(collect);
+        if (_indices.empty())
+            return;
+
+        const osg::Vec3 center = g.getBoundingBox().center() * m;
+        const ChunkKey chunk(_outputs.back().get(), geodeState, int(std::floor(center.x() / _chunkSize)),
+                             int(std::floor(center.y() / _chunkSize)), int(std::floor(center.z() / _chunkSize)));
+        Batch &batch = open(BatchKey(chunk, const_cast<osg::StateSet *>(g.getStateSet()), layout), v.size());
+
+        const unsigned int base = static_cast<unsigned int>(batch.vertices->size());
+        const osg::Matrix normalMatrix = osg::Matrix::inverse(m);
+        const bool normalOverall = n && n->getBinding() == osg::Array::BIND_OVERALL;
+        const bool colorOverall = c && c->getBinding() == osg::Array::BIND_OVERALL;
+        for (size_t i = 0; i < v.size(); ++i)
+        {
+            batch.vertices->push_back(v[i] * m);
+            if (n)
+            {
+                osg::Vec3 normal = osg::Matrix::transform3x3(normalMatrix, (*n)[normalOverall ? 0 : i]);
+                normal.normalize();
+                batch.normals->push_back(normal);
+            }
+            if (c)
+                batch.colors->push_back((*c)[colorOverall ? 0 : i]);
+            if (t)
+                batch.texcoords->push_back((*t)[i]);
+        }
+        for (unsigned int index : _indices)
+            batch.triangles->push_back(base + index);
+    }
+
+    // The batch for key with room for `vertices` more, starting a new one if full
+    Batch &open(const BatchKey &key, size_t vertices)
+    {
+        auto found = _batches.find(key);
+        if (found != _batches.end() && found->second.vertices->size() + vertices <= _maxVertices)
+            return found->second;
+
+        const int layout = std::get<2>(key);
+        Batch batch;
+        batch.geometry = new osg::Geometry;
+        batch.geometry->setUseDisplayList(false);
+        batch.geometry->setUseVertexBufferObjects(true);
+        batch.geometry->setStateSet(std::get<1>(key));
+        batch.vertices = new osg::Vec3Array;
+        batch.geometry->setVertexArray(batch.vertices.get());
+        if (layout & NORMALS)
+        {
+            batch.normals = new osg::Vec3Array;
+            batch.geometry->setNormalArray(batch.normals.get(), osg::Array::BIND_PER_VERTEX);
+        }
+        if (layout & COLORS)
+        {
+            batch.colors = new osg::Vec4Array;
+            batch.geometry->setColorArray(batch.colors.get(), osg::Array::BIND_PER_VERTEX);
+        }
+        if (layout & TEXCOORDS)
+        {
+            batch.texcoords = new osg::Vec2Array;
+            batch.geometry->setTexCoordArray(0, batch.texcoords.get(), osg::Array::BIND_PER_VERTEX);
+        }
+        batch.triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+        batch.geometry->addPrimitiveSet(batch.triangles.get());
+
+        geodeFor(std::get<0>(key))->addDrawable(batch.geometry.get());
+        ++_outputGeometries;
+        _batches[key] = batch;
+        return _batches[key];
+    }
+
+    osg::Geode *geodeFor(const ChunkKey &key)
+    {
+        osg::ref_ptr<osg::Geode> &geode = _chunks[key];
+        if (!geode.valid())
+        {
+            geode = new osg::Geode;
+            geode->setStateSet(std::get<1>(key));
+            std::get<0>(key)->addChild(geode.get());
+        }
+        return geode.get();
+    }
+
+    // Keeps node unmerged, under its accumulated transform
+    void keep(osg::Node &node)
+    {
+        const osg::Matrix &m = _matrices.back();
+        if (m.isIdentity())
+        {
+            _outputs.back()->addChild(&node);
+            return;
+        }
+        osg::ref_ptr<osg::MatrixTransform> xform = new osg::MatrixTransform(m);
+        xform->addChild(&node);
+        _outputs.back()->addChild(xform.get());
+    }
+
+    // A StateSet on a group or transform opens an output group carrying it
+    void enter(osg::StateSet *state)
+    {
+        if (!state)
+            return;
+        osg::ref_ptr<osg::Group> group = new osg::Group;
+        group->setStateSet(state);
+        _outputs.back()->addChild(group.get());
+        _outputs.push_back(group);
+    }
+
+    void leave(osg::StateSet *state)
+    {
+        if (state)
+            _outputs.pop_back();
+    }
+
+    void flush()
+    {
+        for (auto &entry : _batches)
+            entry.second.geometry->dirtyBound();
+        _batches.clear();
+    }
+
+    float _chunkSize;
+    unsigned int _maxVertices;
+    std::vector<osg::Matrix> _matrices;
+    std::vector<osg::ref_ptr<osg::Group>> _outputs;
+    std::map<BatchKey, Batch> _batches;
+    std::map<ChunkKey, osg::ref_ptr<osg::Geode>> _chunks;
+    std::vector<unsigned int> _indices;
+    unsigned int _inputDrawables = 0, _mergedDrawables = 0, _outputGeometries = 0;
+};
@@ -1,7 +1,10 @@
 #include <osg/Group>
+#include <osg/Switch>
 #include <osgDB/ReadFile>
 #include <osgViewer/ViewerEventHandlers>
 #include <osgViewer/CompositeViewer>
+#include <iostream>
+#include "StaticBatcher.hpp"
 
 #define RAND(min, max) \ 
 ((min) + (float)rand() / (RAND_MAX + 1) * ((max) - (min)))
@@ -24,6 +27,46 @@ osg::Geode *createMassiveQuads(unsigned int number)
     return geode.release();
 }
 
+// The scene and its batched copy under one switch; batched is shown first
+osg::Switch *createBatchSwitch(osg::Node *scene, bool batched)
+{
+    StaticBatcher batcher(50.0f);
+    osg::ref_ptr<osg::Node> merged = batcher.run(scene);
+    std::cout << "Batched " << batcher.mergedDrawables() << " of " << batcher.inputDrawables()
+              << " drawables into " << batcher.outputGeometries() << " geometries in "
+              << batcher.chunks() << " chunks\n";
+
+    osg::ref_ptr<osg::Switch> sw = new osg::Switch;
+    sw->addChild(scene, !batched);
+    sw->addChild(merged.get(), batched);
+    return sw.release();
+}
+
+// 'b' flips the scene between the original and the batched copy, so the
+// StatsHandler numbers of both can be compared in the same run
+class BatchToggleHandler : public osgGA::GUIEventHandler
+{
+public:
+    void addSwitch(osg::Switch *sw) { _switches.push_back(sw); }
+
+    bool handle(const osgGA::GUIEventAdapter &ea, osgGA::GUIActionAdapter &) override
+    {
+        if (ea.getEventType() != osgGA::GUIEventAdapter::KEYDOWN || ea.getKey() != 'b')
+            return false;
+        for (osg::Switch *sw : _switches)
+        {
+            const bool batched = !sw->getValue(1);
+            sw->setValue(0, !batched);
+            sw->setValue(1, batched);
+        }
+        std::cout << (_switches.empty() || _switches.front()->getValue(1) ? "Batched" : "Original") << " scenes\n";
+        return true;
+    }
+
+private:
+    std::vector<osg::ref_ptr<osg::Switch>> _switches;
+};
+
 osgViewer::View *createView(int x, int y, int w, int h,
                             osg::Node *scene)
 {
@@ -35,17 +78,28 @@ osgViewer::View *createView(int x, int y, int w, int h,
 
 int main(int argc, char **argv)
 {
+    // All views share one scene: the CompositeViewer keeps one
+    // osgViewer::Scene per scene graph, so update runs once per frame no
+    // matter how many views look at it. Each camera culls on its own thread
+    // and each window draws on its own thread; nothing in the scene is
+    // changed in update, so no node needs DYNAMIC data variance.
+    osgViewer::ViewerBase::ThreadingModel th = osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext;
+
+    // --no-batch starts on the original scene; 'b' toggles either way
+    osg::ArgumentParser arguments(&argc, argv);
+    const bool batched = !arguments.read("--no-batch");
+    if (arguments.read("--single-threaded"))
+        th = osgViewer::ViewerBase::SingleThreaded;
 
-    osgViewer::ViewerBase::ThreadingModel th = osgViewer::ViewerBase::AutomaticSelection;
-    th = osgViewer::ViewerBase::SingleThreaded;
+    osg::ref_ptr<BatchToggleHandler> toggle = new BatchToggleHandler;
+    osg::ref_ptr<osg::Switch> scene = createBatchSwitch(createMassiveQuads(20000), batched);
+    toggle->addSwitch(scene.get());
 
-    osgViewer::View *view1 = createView(50, 50, 640, 480,
-                                        createMassiveQuads(10000));
-    osgViewer::View *view2 = createView(50, 550, 320, 240,
-                                        createMassiveQuads(5000));
-    osgViewer::View *view3 = createView(370, 550, 320, 240,
-                                        createMassiveQuads(5000));
+    osgViewer::View *view1 = createView(50, 50, 640, 480, scene.get());
+    osgViewer::View *view2 = createView(50, 550, 320, 240, scene.get());
+    osgViewer::View *view3 = createView(370, 550, 320, 240, scene.get());
     view1->addEventHandler(new osgViewer::StatsHandler);
+    view1->addEventHandler(toggle.get());
 
     osgViewer::CompositeViewer viewer;
     viewer.setThreadingModel(th);
@@ -53,4 +107,4 @@ int main(int argc, char **argv)
     viewer.addView(view2);
     viewer.addView(view3);
     return viewer.run();
-}
\ No newline at end of file
+}
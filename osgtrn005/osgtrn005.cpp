@@ -3,7 +3,7 @@
 #include <osg/MatrixTransform>
 #include <osgText/Text>
 #include <osgDB/ReadFile>
-#include <osgViewer/Viewer>
+#include <osgViewer/CompositeViewer>
 #include <osgGA/TrackballManipulator>
 #include <osgGA/GUIEventHandler>
 
@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <mutex>
 
 // --- Helper to create axes (same as before)
 osg::ref_ptr<osg::MatrixTransform> createAxis(
@@ -136,90 +137,240 @@ private:
     double _pitch, _yaw, _roll;
 };
 
+// --- One scene, two views
+// Both windows look at the same root; camera cull masks pick what each
+// one shows, so the CompositeViewer runs a single update traversal.
+const osg::Node::NodeMask AXES_VIEW = 0x1;
+const osg::Node::NodeMask MODEL_VIEW = 0x2;
+
+// --- ImGui on the model view only
+// With DrawThreadPerContext every window draws on its own thread. ImGui
+// has one global context, so it is initialised and drawn only on the
+// model window's context; other contexts skip the realize operation.
+class ImGuiInitOperation : public osg::Operation
+{
+public:
+    ImGuiInitOperation(osg::GraphicsContext *gc)
+        : osg::Operation("ImGuiInitOperation", false), _gc(gc) {}
+
+    void operator()(osg::Object *object) override
+    {
+        if (object != _gc.get()) return;
+        if (!ImGui_ImplOpenGL3_Init("#version 130"))
+            std::cout << "ImGui_ImplOpenGL3_Init() failed\n";
+    }
+
+private:
+    osg::observer_ptr<osg::GraphicsContext> _gc;
+};
+
+// Mouse state handed from the event traversal (main thread) to the draw
+// thread, and the load request handed back to the update traversal. The
+// draw thread never touches the scene graph.
+struct UiExchange : public osg::Referenced
+{
+    std::mutex mutex;
+    float mouseX = -1.0f, mouseY = -1.0f;
+    bool mouseDown[3] = {false, false, false};
+    std::string loadRequest;
+};
+
+class UiEventHandler : public osgGA::GUIEventHandler
+{
+public:
+    UiEventHandler(UiExchange *exchange) : _exchange(exchange) {}
+
+    bool handle(const osgGA::GUIEventAdapter &ea, osgGA::GUIActionAdapter &) override
+    {
+        int button = -1;
+        switch (ea.getButton())
+        {
+        case osgGA::GUIEventAdapter::LEFT_MOUSE_BUTTON: button = 0; break;
+        case osgGA::GUIEventAdapter::RIGHT_MOUSE_BUTTON: button = 1; break;
+        case osgGA::GUIEventAdapter::MIDDLE_MOUSE_BUTTON: button = 2; break;
+        default: break;
+        }
+
+        std::lock_guard<std::mutex> lock(_exchange->mutex);
+        switch (ea.getEventType())
+        {
+        case osgGA::GUIEventAdapter::MOVE:
+        case osgGA::GUIEventAdapter::DRAG:
+            _exchange->mouseX = ea.getX();
+            _exchange->mouseY = ea.getWindowHeight() - ea.getY();
+            return false;
+        case osgGA::GUIEventAdapter::PUSH:
+        case osgGA::GUIEventAdapter::RELEASE:
+            if (button >= 0)
+                _exchange->mouseDown[button] = ea.getEventType() == osgGA::GUIEventAdapter::PUSH;
+            return false;
+        default:
+            return false;
+        }
+    }
+
+private:
+    osg::ref_ptr<UiExchange> _exchange;
+};
+
+// Builds and renders the UI after the model camera has drawn
+class UiDrawCallback : public osg::Camera::DrawCallback
+{
+public:
+    UiDrawCallback(UiExchange *exchange) : _exchange(exchange) {}
+
+    void operator()(osg::RenderInfo &renderInfo) const override
+    {
+        const osg::Viewport *vp = renderInfo.getCurrentCamera()->getViewport();
+        const double now = renderInfo.getState()->getFrameStamp()->getReferenceTime();
+
+        ImGuiIO &io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(vp->width(), vp->height());
+        io.DeltaTime = _lastTime > 0.0 && now > _lastTime ? float(now - _lastTime) : 1.0f / 60.0f;
+        _lastTime = now;
+        {
+            std::lock_guard<std::mutex> lock(_exchange->mutex);
+            io.MousePos = ImVec2(_exchange->mouseX, _exchange->mouseY);
+            for (int i = 0; i < 3; ++i) io.MouseDown[i] = _exchange->mouseDown[i];
+        }
+
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui::NewFrame();
+
+        ImGui::Begin("Load Fighter Model");
+        ImGui::InputText("Model Path", _pathBuffer, sizeof(_pathBuffer));
+        if (ImGui::Button("Load"))
+        {
+            std::lock_guard<std::mutex> lock(_exchange->mutex);
+            _exchange->loadRequest = _pathBuffer;
+        }
+        ImGui::End();
+
+        ImGui::Render();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
+
+private:
+    osg::ref_ptr<UiExchange> _exchange;
+    mutable char _pathBuffer[512] = "";
+    mutable double _lastTime = 0.0;
+};
+
+// Applies a pending load request during update
+class ModelLoadCallback : public osg::NodeCallback
+{
+public:
+    ModelLoadCallback(UiExchange *exchange) : _exchange(exchange) {}
+
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(_exchange->mutex);
+            path.swap(_exchange->loadRequest);
+        }
+        if (!path.empty())
+        {
+            osg::MatrixTransform *fighterModelTransform = static_cast<osg::MatrixTransform *>(node);
+            osg::ref_ptr<osg::Node> model = osgDB::readRefNodeFile(path);
+            if (model)
+            {
+                fighterModelTransform->removeChildren(0, fighterModelTransform->getNumChildren());
+                fighterModelTransform->addChild(model);
+
+                // Optional: adjust orientation to NED here
+                osg::Quat rot;
+                rot.makeRotate(osg::Vec3(1,0,0), osg::Vec3(-1,0,0)); // example rotation
+                fighterModelTransform->setMatrix(osg::Matrix::rotate(rot));
+            }
+            else
+                std::cout << "Cannot load " << path << "\n";
+        }
+        traverse(node, nv);
+    }
+
+private:
+    osg::ref_ptr<UiExchange> _exchange;
+};
+
+osgViewer::View *createView(int x, int y, int w, int h, osg::Node *scene, osg::Node::NodeMask mask)
+{
+    osg::ref_ptr<osgViewer::View> view = new osgViewer::View;
+    view->setSceneData(scene);
+    view->setUpViewInWindow(x, y, w, h);
+    view->getCamera()->setCullMask(mask);
+    return view.release();
+}
+
 // --- Main ---
 int main()
 {
     // -----------------------
-    // Axes window
+    // Shared scene
     // -----------------------
-    osg::ref_ptr<osg::Group> root1 = new osg::Group;
-    root1->addChild(createAxes(true, false)); // Reference NED
+    osg::ref_ptr<osg::Group> root = new osg::Group;
+
+    osg::ref_ptr<osg::Group> referenceAxes = createAxes(true, false); // Reference NED
+    referenceAxes->setNodeMask(AXES_VIEW);
+    root->addChild(referenceAxes);
 
     osg::ref_ptr<osg::MatrixTransform> fighterAxesTransform = new osg::MatrixTransform;
     fighterAxesTransform->addChild(createAxes(true, true)); // Body frame
-    root1->addChild(fighterAxesTransform);
+    fighterAxesTransform->setNodeMask(AXES_VIEW);
+    root->addChild(fighterAxesTransform);
 
-    osgViewer::Viewer viewer1;
-    viewer1.setSceneData(root1.get());
-    viewer1.setUpViewInWindow(50,50,600,600);
-    viewer1.getCamera()->setViewMatrixAsLookAt(osg::Vec3(20,20,20), osg::Vec3(0,0,0), osg::Vec3(0,0,1));
+    osg::ref_ptr<UiExchange> exchange = new UiExchange;
+    osg::ref_ptr<osg::MatrixTransform> fighterModelTransform = new osg::MatrixTransform;
+    fighterModelTransform->setNodeMask(MODEL_VIEW);
+    fighterModelTransform->setUpdateCallback(new ModelLoadCallback(exchange.get()));
+    root->addChild(fighterModelTransform);
+
+    // -----------------------
+    // Axes window
+    // -----------------------
+    osg::ref_ptr<osgViewer::View> axesView = createView(50, 50, 600, 600, root.get(), AXES_VIEW);
+    axesView->getCamera()->setViewMatrixAsLookAt(osg::Vec3(20,20,20), osg::Vec3(0,0,0), osg::Vec3(0,0,1));
 
     // -----------------------
     // Fighter model window
     // -----------------------
-    osg::ref_ptr<osg::Group> root2 = new osg::Group;
-    osg::ref_ptr<osg::MatrixTransform> fighterModelTransform = new osg::MatrixTransform;
-    root2->addChild(fighterModelTransform);
+    osg::ref_ptr<osgViewer::View> modelView = createView(700, 50, 600, 600, root.get(), MODEL_VIEW);
+    modelView->setCameraManipulator(new osgGA::TrackballManipulator);
 
-    osgViewer::Viewer viewer2;
-    viewer2.setSceneData(root2.get());
-    viewer2.setUpViewInWindow(700,50,600,600);
-    viewer2.setCameraManipulator(new osgGA::TrackballManipulator);
-    viewer2.home();
+    // Fighter keyboard
+    modelView->addEventHandler(new FighterControlHandler(fighterModelTransform, fighterAxesTransform));
 
     // -----------------------
-    // Wait until context exists before ImGui init
+    // ImGui, model window only
     // -----------------------
-    viewer2.realize(); // creates OpenGL context
-
-    // Initialize ImGui
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
-    ImGuiIO& io = ImGui::GetIO();
     ImGui::StyleColorsDark();
-    ImGui_ImplOpenGL3_Init("#version 130");
+    modelView->addEventHandler(new UiEventHandler(exchange.get()));
+    modelView->getCamera()->setFinalDrawCallback(new UiDrawCallback(exchange.get()));
 
-    // Fighter keyboard
-    viewer2.addEventHandler(new FighterControlHandler(fighterModelTransform, fighterAxesTransform));
+    osgViewer::CompositeViewer viewer;
+    viewer.setThreadingModel(osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext);
+    viewer.addView(axesView.get());
+    viewer.addView(modelView.get());
+    viewer.setRealizeOperation(new ImGuiInitOperation(modelView->getCamera()->getGraphicsContext()));
+    viewer.realize();
+    modelView->home();
 
     // -----------------------
     // Main loop
     // -----------------------
-    std::string modelPath;
-    while (!viewer1.done() && !viewer2.done())
-    {
-        // ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui::NewFrame();
-
-        // Example window
-        ImGui::Begin("Load Fighter Model");
-        static char pathBuffer[512] = "";
-        ImGui::InputText("Model Path", pathBuffer, sizeof(pathBuffer));
-        if (ImGui::Button("Load"))
-        {
-            std::string path = pathBuffer;
-            osg::ref_ptr<osg::Node> node = osgDB::readRefNodeFile(path);
-            if (node)
-            {
-                fighterModelTransform->removeChildren(0,fighterModelTransform->getNumChildren());
-                fighterModelTransform->addChild(node);
+    while (!viewer.done())
+        viewer.frame();
 
-                // Optional: adjust orientation to NED here
-                osg::Quat rot;
-                rot.makeRotate(osg::Vec3(1,0,0), osg::Vec3(-1,0,0)); // example rotation
-                fighterModelTransform->setMatrix(osg::Matrix::rotate(rot));
-            }
-        }
-        ImGui::End();
-
-        ImGui::Render();
-        viewer2.frame();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        viewer1.frame();
+    // Draw threads are gone after this; shut ImGui down on its own context
+    viewer.stopThreading();
+    osg::GraphicsContext *gc = modelView->getCamera()->getGraphicsContext();
+    if (gc && gc->makeCurrent())
+    {
+        ImGui_ImplOpenGL3_Shutdown();
+        gc->releaseContext();
     }
-
-    ImGui_ImplOpenGL3_Shutdown();
     ImGui::DestroyContext();
 
     return 0;
@@ -21,6 +21,8 @@ struct OsgImGuiHandler::ImGuiNewFrameCallback : public osg::Camera::DrawCallback
         handler_.newFrame(renderInfo);
     }
 
+    OsgImGuiHandler &handler() const { return handler_; }
+
 private:
     OsgImGuiHandler &handler_;
 };
@@ -42,25 +44,33 @@ private:
 };
 
 OsgImGuiHandler::OsgImGuiHandler()
-    : time_(0.0f), mousePressed_{false}, mouseWheel_(0.0f), initialized_(false)
+    : time_(0.0f), initialized_(false), ownsCamera_(false), wantCaptureMouse_(false), wantCaptureKeyboard_(false)
 {
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGuiIO &io = ImGui::GetIO();
-    (void)io;
-    init();
+    if (!ImGui::GetCurrentContext())
+    {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+    }
 }
 
 /**
- * Imporant Note: Dear ImGui expects the control Keys indices not to be
- * greater thant 511. It actually uses an array of 512 elements. However,
- * OSG has indices greater than that. So here I do a conversion for special
- * keys between ImGui and OSG.
+ * Maps an unmodified OSG key symbol to the ImGuiKey it stands for, or
+ * ImGuiKey_None. Printable keys are also sent to ImGui as characters;
+ * this covers the keys ImGui uses for navigation and shortcuts.
  */
-static int ConvertFromOSGKey(int key)
+static ImGuiKey ConvertFromOSGKey(int key)
 {
     using KEY = osgGA::GUIEventAdapter::KeySymbol;
 
+    if (key >= 'a' && key <= 'z')
+        return ImGuiKey(ImGuiKey_A + (key - 'a'));
+    if (key >= 'A' && key <= 'Z')
+        return ImGuiKey(ImGuiKey_A + (key - 'A'));
+    if (key >= '0' && key <= '9')
+        return ImGuiKey(ImGuiKey_0 + (key - '0'));
+    if (key >= KEY::KEY_F1 && key <= KEY::KEY_F12)
+        return ImGuiKey(ImGuiKey_F1 + (key - KEY::KEY_F1));
+
     switch (key)
     {
     case KEY::KEY_Tab:
@@ -81,49 +91,61 @@ static int ConvertFromOSGKey(int key)
         return ImGuiKey_Home;
     case KEY::KEY_End:
         return ImGuiKey_End;
+    case KEY::KEY_Insert:
+        return ImGuiKey_Insert;
     case KEY::KEY_Delete:
         return ImGuiKey_Delete;
     case KEY::KEY_BackSpace:
         return ImGuiKey_Backspace;
+    case KEY::KEY_Space:
+        return ImGuiKey_Space;
     case KEY::KEY_Return:
         return ImGuiKey_Enter;
+    case KEY::KEY_KP_Enter:
+        return ImGuiKey_KeypadEnter;
     case KEY::KEY_Escape:
         return ImGuiKey_Escape;
+    case KEY::KEY_Shift_L:
+        return ImGuiKey_LeftShift;
+    case KEY::KEY_Shift_R:
+        return ImGuiKey_RightShift;
+    case KEY::KEY_Control_L:
+        return ImGuiKey_LeftCtrl;
+    case KEY::KEY_Control_R:
+        return ImGuiKey_RightCtrl;
+    case KEY::KEY_Alt_L:
+        return ImGuiKey_LeftAlt;
+    case KEY::KEY_Alt_R:
+        return ImGuiKey_RightAlt;
+    case KEY::KEY_Super_L:
+        return ImGuiKey_LeftSuper;
+    case KEY::KEY_Super_R:
+        return ImGuiKey_RightSuper;
     default: // Not found
-        return -1;
+        return ImGuiKey_None;
     }
 }
 
-void OsgImGuiHandler::init()
+void OsgImGuiHandler::setCameraCallbacks(osg::Camera *camera)
 {
-    ImGuiIO &io = ImGui::GetIO();
+    // Setting the callbacks again would replace the first handler's; join
+    // it instead
+    auto *existing = dynamic_cast<ImGuiNewFrameCallback *>(camera->getPreDrawCallback());
+    if (existing)
+    {
+        existing->handler().addPanel(this);
+        return;
+    }
 
-    // Keyboard mapping. ImGui will use those indices to peek into the io.KeyDown[] array.
-    io.KeyMap[ImGuiKey_Tab] = ImGuiKey_Tab;
-    io.KeyMap[ImGuiKey_LeftArrow] = ImGuiKey_LeftArrow;
-    io.KeyMap[ImGuiKey_RightArrow] = ImGuiKey_RightArrow;
-    io.KeyMap[ImGuiKey_UpArrow] = ImGuiKey_UpArrow;
-    io.KeyMap[ImGuiKey_DownArrow] = ImGuiKey_DownArrow;
-    io.KeyMap[ImGuiKey_PageUp] = ImGuiKey_PageUp;
-    io.KeyMap[ImGuiKey_PageDown] = ImGuiKey_PageDown;
-    io.KeyMap[ImGuiKey_Home] = ImGuiKey_Home;
-    io.KeyMap[ImGuiKey_End] = ImGuiKey_End;
-    io.KeyMap[ImGuiKey_Delete] = ImGuiKey_Delete;
-    io.KeyMap[ImGuiKey_Backspace] = ImGuiKey_Backspace;
-    io.KeyMap[ImGuiKey_Enter] = ImGuiKey_Enter;
-    io.KeyMap[ImGuiKey_Escape] = ImGuiKey_Escape;
-    io.KeyMap[ImGuiKey_A] = osgGA::GUIEventAdapter::KeySymbol::KEY_A;
-    io.KeyMap[ImGuiKey_C] = osgGA::GUIEventAdapter::KeySymbol::KEY_C;
-    io.KeyMap[ImGuiKey_V] = osgGA::GUIEventAdapter::KeySymbol::KEY_V;
-    io.KeyMap[ImGuiKey_X] = osgGA::GUIEventAdapter::KeySymbol::KEY_X;
-    io.KeyMap[ImGuiKey_Y] = osgGA::GUIEventAdapter::KeySymbol::KEY_Y;
-    io.KeyMap[ImGuiKey_Z] = osgGA::GUIEventAdapter::KeySymbol::KEY_Z;
+    ownsCamera_ = true;
+    camera->setPreDrawCallback(new ImGuiNewFrameCallback(*this));
+    camera->setPostDrawCallback(new ImGuiRenderCallback(*this));
 }
 
-void OsgImGuiHandler::setCameraCallbacks(osg::Camera *camera)
+void OsgImGuiHandler::addPanel(OsgImGuiHandler *panel)
 {
-    camera->setPreDrawCallback(new ImGuiNewFrameCallback(*this));
-    camera->setPostDrawCallback(new ImGuiRenderCallback(*this));
+    std::lock_guard<std::mutex> lock(mutex_);
+    panels_.push_back(panel);
 }
 
 void OsgImGuiHandler::newFrame(osg::RenderInfo &renderInfo)
@@ -139,20 +161,62 @@ void OsgImGuiHandler::newFrame(osg::RenderInfo &renderInfo)
     io.DeltaTime = currentTime - time_ + 0.0000001;
     time_ = currentTime;
 
-    for (int i = 0; i < 3; i++)
+    // Replay the input recorded since the last frame, in order
+    std::vector<InputEvent> input;
     {
-        io.MouseDown[i] = mousePressed_[i];
+        std::lock_guard<std::mutex> lock(mutex_);
+        input.swap(pendingInput_);
+    }
+    for (const InputEvent &e : input)
+    {
+        switch (e.type)
+        {
+        case InputEvent::Key:
+            io.AddKeyEvent(ImGuiKey(e.code), e.down);
+            break;
+        case InputEvent::Modifiers:
+            io.AddKeyEvent(ImGuiMod_Ctrl, (e.code & osgGA::GUIEventAdapter::MODKEY_CTRL) != 0);
+            io.AddKeyEvent(ImGuiMod_Shift, (e.code & osgGA::GUIEventAdapter::MODKEY_SHIFT) != 0);
+            io.AddKeyEvent(ImGuiMod_Alt, (e.code & osgGA::GUIEventAdapter::MODKEY_ALT) != 0);
+            io.AddKeyEvent(ImGuiMod_Super, (e.code & osgGA::GUIEventAdapter::MODKEY_SUPER) != 0);
+            break;
+        case InputEvent::Character:
+            io.AddInputCharacter((unsigned int)e.code);
+            break;
+        case InputEvent::MousePos:
+            io.AddMousePosEvent(e.x, io.DisplaySize.y - e.y);
+            break;
+        case InputEvent::MouseButton:
+            io.AddMouseButtonEvent(e.code, e.down);
+            break;
+        case InputEvent::MouseWheel:
+            io.AddMouseWheelEvent(0.0f, e.y);
+            break;
+        }
     }
-
-    io.MouseWheel = mouseWheel_;
-    mouseWheel_ = 0.0f;
 
     ImGui::NewFrame();
+
+    wantCaptureMouse_ = io.WantCaptureMouse;
+    wantCaptureKeyboard_ = io.WantCaptureKeyboard;
 }
 
 void OsgImGuiHandler::render(osg::RenderInfo &)
 {
     drawUi();
+
+    std::vector<osg::observer_ptr<OsgImGuiHandler>> panels;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        panels = panels_;
+    }
+    for (const osg::observer_ptr<OsgImGuiHandler> &p : panels)
+    {
+        osg::ref_ptr<OsgImGuiHandler> panel;
+        if (p.lock(panel))
+            panel->drawUi();
+    }
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
@@ -169,9 +233,13 @@ bool OsgImGuiHandler::handle(const osgGA::GUIEventAdapter &ea, osgGA::GUIActionA
         }
     }
 
-    ImGuiIO &io = ImGui::GetIO();
-    const bool wantCaptureMouse = io.WantCaptureMouse;
-    const bool wantCaptureKeyboard = io.WantCaptureKeyboard;
+    // Only the camera's owner feeds ImGui; the others would queue input
+    // that is never drained
+    if (!ownsCamera_)
+        return false;
+
+    InputEvent e = {};
+    std::lock_guard<std::mutex> lock(mutex_);
 
     switch (ea.getEventType())
     {
@@ -180,43 +248,63 @@ bool OsgImGuiHandler::handle(const osgGA::GUIEventAdapter &ea, osgGA::GUIActionA
     {
         const bool isKeyDown = ea.getEventType() == osgGA::GUIEventAdapter::KEYDOWN;
         const int c = ea.getKey();
-        const int special_key = ConvertFromOSGKey(c);
-        if (special_key > 0)
-        {
-            assert((special_key >= 0 && special_key < 512) && "ImGui KeysMap is an array of 512");
 
-            io.KeysDown[special_key] = isKeyDown;
+        e.type = InputEvent::Modifiers;
+        e.code = ea.getModKeyMask();
+        pendingInput_.push_back(e);
 
-            io.KeyCtrl = ea.getModKeyMask() & osgGA::GUIEventAdapter::MODKEY_CTRL;
-            io.KeyShift = ea.getModKeyMask() & osgGA::GUIEventAdapter::MODKEY_SHIFT;
-            io.KeyAlt = ea.getModKeyMask() & osgGA::GUIEventAdapter::MODKEY_ALT;
-            io.KeySuper = ea.getModKeyMask() & osgGA::GUIEventAdapter::MODKEY_SUPER;
+        // Ctrl+letter arrives from getKey() as a control character
+        const ImGuiKey key = ConvertFromOSGKey(ea.getUnmodifiedKey());
+        if (key != ImGuiKey_None)
+        {
+            e.type = InputEvent::Key;
+            e.code = key;
+            e.down = isKeyDown;
+            pendingInput_.push_back(e);
         }
-        else if (isKeyDown && c > 0 && c < 0xFF)
+        if (isKeyDown && c >= ' ' && c < 0xFF && c != 0x7F)
         {
-            io.AddInputCharacter((unsigned short)c);
+            e.type = InputEvent::Character;
+            e.code = c;
+            pendingInput_.push_back(e);
         }
-        return wantCaptureKeyboard;
+        return wantCaptureKeyboard_;
     }
     case (osgGA::GUIEventAdapter::RELEASE):
     case (osgGA::GUIEventAdapter::PUSH):
     {
-        io.MousePos = ImVec2(ea.getX(), io.DisplaySize.y - ea.getY());
-        mousePressed_[0] = ea.getButtonMask() & osgGA::GUIEventAdapter::LEFT_MOUSE_BUTTON;
-        mousePressed_[1] = ea.getButtonMask() & osgGA::GUIEventAdapter::RIGHT_MOUSE_BUTTON;
-        mousePressed_[2] = ea.getButtonMask() & osgGA::GUIEventAdapter::MIDDLE_MOUSE_BUTTON;
-        return wantCaptureMouse;
+        e.type = InputEvent::MousePos;
+        e.x = ea.getX();
+        e.y = ea.getY();
+        pendingInput_.push_back(e);
+
+        const int buttons[3] = {osgGA::GUIEventAdapter::LEFT_MOUSE_BUTTON,
+                                osgGA::GUIEventAdapter::RIGHT_MOUSE_BUTTON,
+                                osgGA::GUIEventAdapter::MIDDLE_MOUSE_BUTTON};
+        e.type = InputEvent::MouseButton;
+        for (int i = 0; i < 3; i++)
+        {
+            e.code = i;
+            e.down = (ea.getButtonMask() & buttons[i]) != 0;
+            pendingInput_.push_back(e);
+        }
+        return wantCaptureMouse_;
     }
     case (osgGA::GUIEventAdapter::DRAG):
     case (osgGA::GUIEventAdapter::MOVE):
     {
-        io.MousePos = ImVec2(ea.getX(), io.DisplaySize.y - ea.getY());
-        return wantCaptureMouse;
+        e.type = InputEvent::MousePos;
+        e.x = ea.getX();
+        e.y = ea.getY();
+        pendingInput_.push_back(e);
+        return wantCaptureMouse_;
     }
     case (osgGA::GUIEventAdapter::SCROLL):
     {
-        mouseWheel_ = ea.getScrollingMotion() == osgGA::GUIEventAdapter::SCROLL_UP ? 1.0 : -1.0;
-        return wantCaptureMouse;
+        e.type = InputEvent::MouseWheel;
+        e.y = ea.getScrollingMotion() == osgGA::GUIEventAdapter::SCROLL_UP ? 1.0f : -1.0f;
+        pendingInput_.push_back(e);
+        return wantCaptureMouse_;
     }
     default:
     {
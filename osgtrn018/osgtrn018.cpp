@@ -6,7 +6,13 @@
 #include <osgGA/NodeTrackerManipulator>
 #include <osgGA/GUIEventHandler>
 #include <osg/AnimationPath>
+#include <osg/Texture2D>
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <vector>
+
+#include "CommonFunctions"
 
 // ===== Keyboard Handler to adjust active camera marker =====
 class CameraAdjustHandler : public osgGA::GUIEventHandler
@@ -192,10 +198,118 @@ osg::Node *createReferenceCircle(float radius, unsigned int segments = 128)
     return geode.release();
 }
 
+// ===== Picture-in-picture insets =====
+// Each marker also gets a small RTT camera whose texture is shown in a
+// HUD inset, so all markers are visible at once. An inset renders at most
+// `rate` times per second (0 = every frame) at its own resolution; on the
+// other frames its camera is left out of the cull traversal and the
+// texture keeps the last image, so an inset costs a bounded share of the
+// frame.
+struct InsetSettings
+{
+    double rate = 15.0;
+    int width = 320;
+    int height = 240;
+};
+
+// Places the inset camera at its marker, looking along the marker's +Y
+// with +Z up. It does not traverse: the scene below the camera is already
+// updated through the main scene graph.
+class InsetUpdateCallback : public osg::NodeCallback
+{
+public:
+    InsetUpdateCallback(osg::MatrixTransform *marker) : _marker(marker) {}
+
+    void operator()(osg::Node *node, osg::NodeVisitor *) override
+    {
+        osg::Camera *camera = static_cast<osg::Camera *>(node);
+        // The first path is the one through the root; the scene has the
+        // inset cameras as further parents
+        osg::MatrixList worlds = _marker->getWorldMatrices();
+        if (!worlds.empty())
+            camera->setViewMatrix(osg::Matrix::inverse(worlds.front()) *
+                                  osg::Matrix::rotate(-osg::PI_2, osg::X_AXIS));
+    }
+
+private:
+    osg::observer_ptr<osg::MatrixTransform> _marker;
+};
+
+// Lets the inset camera into the cull traversal only when it is due. It
+// sits on a group above the camera: the cull visitor sets up a camera's
+// render stage, and its clear, before the camera's own callback runs.
+class InsetRateCallback : public osg::NodeCallback
+{
+public:
+    InsetRateCallback(double rate) : _period(rate > 0.0 ? 1.0 / rate : 0.0), _next(0.0) {}
+
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        const double t = nv->getFrameStamp()->getReferenceTime();
+        if (t < _next)
+            return;
+        // Catch up without bursts after a stall
+        _next = std::max(_next + _period, t);
+        traverse(node, nv);
+    }
+
+private:
+    double _period, _next;
+};
+
+osg::Node *createInset(osg::Node *scene, osg::MatrixTransform *marker,
+                       const InsetSettings &settings, osg::Texture2D *texture)
+{
+    texture->setTextureSize(settings.width, settings.height);
+    texture->setInternalFormat(GL_RGBA);
+
+    osg::ref_ptr<osg::Camera> camera = osgCookBook::createRTTCamera(osg::Camera::COLOR_BUFFER, texture);
+    camera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+    camera->setClearColor(osg::Vec4(0.2f, 0.2f, 0.4f, 1.0f));
+    camera->setProjectionMatrixAsPerspective(50.0, double(settings.width) / settings.height, 1.0, 5000.0);
+    camera->addChild(scene);
+    camera->setUpdateCallback(new InsetUpdateCallback(marker));
+
+    osg::ref_ptr<osg::Group> gate = new osg::Group;
+    gate->setCullCallback(new InsetRateCallback(settings.rate));
+    gate->addChild(camera.get());
+    return gate.release();
+}
+
+// Insets along the bottom of the window, in 0..1 HUD coordinates
+osg::Camera *createInsetHUD(const std::vector<osg::ref_ptr<osg::Texture2D>> &textures,
+                            const InsetSettings &settings)
+{
+    osg::ref_ptr<osg::Camera> hud = osgCookBook::createHUDCamera(0.0, 1.0, 0.0, 1.0);
+    const float margin = 0.01f;
+    const float w = (1.0f - margin * (textures.size() + 1)) / textures.size();
+    const float h = w * settings.height / settings.width;
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        osg::ref_ptr<osg::MatrixTransform> inset = new osg::MatrixTransform;
+        inset->setMatrix(osg::Matrix::translate(margin + i * (w + margin), margin, 0.0f));
+        osg::Geode *quad = osgCookBook::createScreenQuad(w, h);
+        quad->getOrCreateStateSet()->setTextureAttributeAndModes(0, textures[i].get());
+        inset->addChild(quad);
+        hud->addChild(inset.get());
+    }
+    return hud.release();
+}
+
 int main(int argc, char **argv)
 {
     osg::ref_ptr<osg::Group> root = new osg::Group();
 
+    // --inset-rate <Hz> (0 = every frame), --inset-size <width> <height>
+    osg::ArgumentParser arguments(&argc, argv);
+    InsetSettings insets;
+    arguments.read("--inset-rate", insets.rate);
+    arguments.read("--inset-size", insets.width, insets.height);
+
+    // What the insets see: everything but the HUD
+    osg::ref_ptr<osg::Group> scene = new osg::Group;
+    root->addChild(scene.get());
+
     std::string dataPath = "/home/murate/Documents/SwTrn/OsgTrn/OpenSceneGraph-Data/";
     osg::ref_ptr<osg::Node> cessna = osgDB::readNodeFile(dataPath + "cessna.osg.0,0,90.rot");
     if (!cessna)
@@ -206,7 +320,7 @@ int main(int argc, char **argv)
 
     osg::ref_ptr<osg::MatrixTransform> cessnaXform = new osg::MatrixTransform;
     cessnaXform->addChild(cessna.get());
-    root->addChild(cessnaXform.get());
+    scene->addChild(cessnaXform.get());
 
     osg::ref_ptr<osg::AnimationPathCallback> apcb = new osg::AnimationPathCallback;
     float radius = 100.0f;
@@ -214,7 +328,7 @@ int main(int argc, char **argv)
     cessnaXform->setUpdateCallback(apcb.get());
 
     // Reference circle
-    root->addChild(createReferenceCircle(radius));
+    scene->addChild(createReferenceCircle(radius));
 
     // Camera marker nodes
     osg::ref_ptr<osg::MatrixTransform> tailNode = new osg::MatrixTransform;
@@ -241,6 +355,17 @@ int main(int argc, char **argv)
     cessnaXform->addChild(cockpitNode.get());
     cessnaXform->addChild(topNode.get());
 
+    // One inset per marker
+    std::vector<osg::ref_ptr<osg::Texture2D>> textures;
+    for (osg::MatrixTransform *marker : {tailNode.get(), wingNode.get(), cockpitNode.get(), topNode.get()})
+    {
+        textures.push_back(new osg::Texture2D);
+        root->addChild(createInset(scene.get(), marker, insets, textures.back().get()));
+    }
+    root->addChild(createInsetHUD(textures, insets));
+    std::cout << "Insets: " << insets.width << "x" << insets.height << " at "
+              << (insets.rate > 0.0 ? std::to_string(insets.rate) + " Hz" : std::string("frame rate")) << "\n";
+
     osgViewer::Viewer viewer;
     viewer.setUpViewInWindow(700, 50, 600, 600);
     viewer.setSceneData(root.get());
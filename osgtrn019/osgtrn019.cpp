@@ -2,7 +2,8 @@
 #include <osg/Geode>
 #include <osg/MatrixTransform>
 #include <osgDB/ReadFile>
-#include <osgViewer/Viewer>
+#include <osgViewer/CompositeViewer>
+#include <osgViewer/ViewerEventHandlers>
 #include <osgGA/NodeTrackerManipulator>
 #include <osgGA/GUIEventHandler>
 #include <osg/AnimationPath>
@@ -173,6 +174,27 @@ osg::Node* createReferenceCircle(float radius, unsigned int segments = 128)
     return geode.release();
 }
 
+// ===== Operator station view =====
+// One view per camera marker, all on the same root. The CompositeViewer
+// keeps one osgViewer::Scene per scene graph, so the Cessna's update
+// callback runs once per frame however many views are open.
+osgViewer::View* createTrackerView(int x, int y, int w, int h, osg::Node* scene,
+                                   osg::MatrixTransform* marker)
+{
+    osg::ref_ptr<osgViewer::View> view = new osgViewer::View;
+    view->setUpViewInWindow(x, y, w, h);
+    view->setSceneData(scene);
+
+    osg::ref_ptr<osgGA::NodeTrackerManipulator> manip = new osgGA::NodeTrackerManipulator;
+    manip->setTrackNode(marker);
+    manip->setTrackerMode(osgGA::NodeTrackerManipulator::NODE_CENTER_AND_ROTATION);
+    manip->setRotationMode(osgGA::NodeTrackerManipulator::TRACKBALL);
+    view->setCameraManipulator(manip.get());
+
+    view->addEventHandler(new CameraAdjustHandler(marker));
+    return view.release();
+}
+
 int main()
 {
     osg::ref_ptr<osg::Group> root = new osg::Group();
@@ -213,22 +235,32 @@ int main()
     cessnaXform->addChild(cockpitNode.get());
     cessnaXform->addChild(topNode.get());
 
-    osgViewer::Viewer viewer;
-    viewer.setUpViewInWindow(700,50,800,600);
-    viewer.setSceneData(root.get());
+    // Main view: starts on the tail, keys 1-4 switch its marker
+    osg::ref_ptr<osgViewer::View> mainView = new osgViewer::View;
+    mainView->setUpViewInWindow(700,50,800,600);
+    mainView->setSceneData(root.get());
 
     osg::ref_ptr<osgGA::NodeTrackerManipulator> manip = new osgGA::NodeTrackerManipulator;
     manip->setTrackNode(tailNode.get());
     manip->setTrackerMode(osgGA::NodeTrackerManipulator::NODE_CENTER_AND_ROTATION);
     manip->setRotationMode(osgGA::NodeTrackerManipulator::TRACKBALL);
-    viewer.setCameraManipulator(manip.get());
+    mainView->setCameraManipulator(manip.get());
 
     osg::ref_ptr<CameraAdjustHandler> adjustHandler = new CameraAdjustHandler(tailNode.get());
-    viewer.addEventHandler(adjustHandler.get());
+    mainView->addEventHandler(adjustHandler.get());
 
     osg::ref_ptr<CameraSwitchHandler> switchHandler = 
         new CameraSwitchHandler(manip.get(), tailNode.get(), wingNode.get(), cockpitNode.get(), topNode.get(), adjustHandler.get());
-    viewer.addEventHandler(switchHandler.get());
+    mainView->addEventHandler(switchHandler.get());
+    mainView->addEventHandler(new osgViewer::StatsHandler);
+
+    // Fixed wing, cockpit and top views below it
+    osgViewer::CompositeViewer viewer;
+    viewer.setThreadingModel(osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext);
+    viewer.addView(mainView.get());
+    viewer.addView(createTrackerView(700,680,264,200, root.get(), wingNode.get()));
+    viewer.addView(createTrackerView(968,680,264,200, root.get(), cockpitNode.get()));
+    viewer.addView(createTrackerView(1236,680,264,200, root.get(), topNode.get()));
 
     return viewer.run();
 }
\ No newline at end of file
@@ -1,120 +1,152 @@
 #include <osg/Geode>
 #include <osg/Geometry>
-#include <osg/Texture2D>
-#include <osg/MatrixTransform>
+#include <osg/Depth>
+#include <osg/Program>
+#include <osg/Uniform>
 #include <osgViewer/Viewer>
 #include <osgGA/TrackballManipulator>
 #include <osg/NodeCallback>
 #include <osg/StateSet>
-#include <osg/Image>
+#include <osgUtil/CullVisitor>
+#include <cmath>
+
+// ---------- Infinite ground grid ----------
+// The ground is the plane y = 0, drawn as one triangle covering the
+// screen. The fragment shader intersects each pixel's view ray with the
+// plane, writes the hit's depth, and draws minor/major grid lines
+// anti-aliased with fwidth(), fading them with distance. Nothing follows
+// the camera and no texture is uploaded.
+//
+// Precision: the shader works relative to the eye. The only absolute
+// input is the eye position wrapped to one major cell, computed in double
+// precision on the CPU, so the grid is as sharp a million units out as at
+// the origin.
+const float MINOR_SPACING = 10.0f;
+const float MAJOR_SPACING = 100.0f;
+
+struct NoBoundingBox : public osg::Drawable::ComputeBoundingBoxCallback
+{
+    osg::BoundingBox computeBound(const osg::Drawable&) const override { return osg::BoundingBox(); }
+};
 
-// ---------- Create a simple color texture ----------
-osg::ref_ptr<osg::Image> createColorImage(int size = 256, osg::Vec4 color = osg::Vec4(0.6, 0.6, 0.6, 1.0))
+// Hands the eye position to the shader: x/z wrapped to a major cell, y
+// (the height above the plane) as is
+class GroundEyeCallback : public osg::NodeCallback
 {
-    osg::ref_ptr<osg::Image> image = new osg::Image();
-    image->allocateImage(size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+public:
+    GroundEyeCallback(osg::Uniform* eye) : _eye(eye) {}
 
-    for (int y = 0; y < size; ++y)
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
     {
-        for (int x = 0; x < size; ++x)
-        {
-            unsigned char* pixel = image->data(x, y);
-            pixel[0] = static_cast<unsigned char>(color.r() * 255);
-            pixel[1] = static_cast<unsigned char>(color.g() * 255);
-            pixel[2] = static_cast<unsigned char>(color.b() * 255);
-            pixel[3] = static_cast<unsigned char>(color.a() * 255);
-        }
+        osgUtil::CullVisitor* cv = static_cast<osgUtil::CullVisitor*>(nv);
+        const osg::Vec3d eye = cv->getCurrentCamera()->getInverseViewMatrix().getTrans();
+        _eye->set(osg::Vec3(std::fmod(eye.x(), double(MAJOR_SPACING)), eye.y(),
+                            std::fmod(eye.z(), double(MAJOR_SPACING))));
+        traverse(node, nv);
     }
-    return image;
-}
 
-// ---------- Create the textured ground ----------
-osg::ref_ptr<osg::Geode> createGround(float size = 1000.0f)
-{
-    osg::ref_ptr<osg::Geometry> geom = new osg::Geometry();
+private:
+    osg::ref_ptr<osg::Uniform> _eye;
+};
 
+osg::ref_ptr<osg::Geode> createGround()
+{
+    // Clip-space corners; (-1,-1) (3,-1) (-1,3) covers the whole viewport
     osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array();
-    vertices->push_back(osg::Vec3(-size, 0, -size));
-    vertices->push_back(osg::Vec3(size, 0, -size));
-    vertices->push_back(osg::Vec3(size, 0, size));
-    vertices->push_back(osg::Vec3(-size, 0, size));
-    geom->setVertexArray(vertices);
-
-    osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array();
-    texcoords->push_back(osg::Vec2(0.0f, 0.0f));
-    texcoords->push_back(osg::Vec2(10.0f, 0.0f));
-    texcoords->push_back(osg::Vec2(10.0f, 10.0f));
-    texcoords->push_back(osg::Vec2(0.0f, 10.0f));
-    geom->setTexCoordArray(0, texcoords);
+    vertices->push_back(osg::Vec3(-1.0f, -1.0f, 0.0f));
+    vertices->push_back(osg::Vec3(3.0f, -1.0f, 0.0f));
+    vertices->push_back(osg::Vec3(-1.0f, 3.0f, 0.0f));
 
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(GL_QUADS);
-    indices->push_back(0);
-    indices->push_back(1);
-    indices->push_back(2);
-    indices->push_back(3);
-    geom->addPrimitiveSet(indices);
+    osg::ref_ptr<osg::Geometry> geom = new osg::Geometry();
+    geom->setVertexArray(vertices);
+    geom->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLES, 0, 3));
+    // Never culled, and kept out of the near/far computation
+    geom->setComputeBoundingBoxCallback(new NoBoundingBox);
+
+    static const char* vertSrc =
+        "#version 120\n"
+        "varying vec3 eyeRay;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(gl_Vertex.xy, 0.0, 1.0);\n"
+        "    vec4 eye = gl_ProjectionMatrixInverse * vec4(gl_Vertex.xy, 1.0, 1.0);\n"
+        "    eyeRay = eye.xyz / eye.w;\n"
+        "}\n";
+    static const char* fragSrc =
+        "#version 120\n"
+        "uniform mat4 osg_ViewMatrixInverse;\n"
+        "uniform vec3 groundEye;\n"
+        "uniform vec2 gridSpacing;\n"
+        "uniform vec3 groundColor;\n"
+        "uniform vec3 lineColor;\n"
+        "uniform float fadeDistance;\n"
+        "varying vec3 eyeRay;\n"
+        "float gridLine(vec2 coord)\n"
+        "{\n"
+        "    vec2 d = abs(fract(coord - 0.5) - 0.5) / fwidth(coord);\n"
+        "    return 1.0 - min(min(d.x, d.y), 1.0);\n"
+        "}\n"
+        "void main()\n"
+        "{\n"
+        "    vec3 dir = mat3(osg_ViewMatrixInverse) * eyeRay;\n"
+        "    float t = -groundEye.y / dir.y;\n"
+        "    if (t <= 0.0) discard;\n"
+        "    vec3 hit = dir * t;\n"
+        "    vec2 coord = groundEye.xz + hit.xz;\n"
+        "    float dist = length(hit);\n"
+        "    float fade = 1.0 - smoothstep(0.25 * fadeDistance, fadeDistance, dist);\n"
+        "    float minor = gridLine(coord / gridSpacing.x) * (1.0 - smoothstep(0.1, 0.35, dist / fadeDistance));\n"
+        "    float major = gridLine(coord / gridSpacing.y);\n"
+        "    float line = max(0.5 * minor, major) * fade;\n"
+        "    gl_FragColor = vec4(mix(groundColor, lineColor, line), 1.0);\n"
+        "    vec4 clip = gl_ProjectionMatrix * vec4(eyeRay * t, 1.0);\n"
+        "    gl_FragDepth = 0.5 * clip.z / clip.w + 0.5;\n"
+        "}\n";
+
+    osg::ref_ptr<osg::Program> program = new osg::Program;
+    program->addShader(new osg::Shader(osg::Shader::VERTEX, vertSrc));
+    program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragSrc));
+
+    osg::ref_ptr<osg::Uniform> eye = new osg::Uniform("groundEye", osg::Vec3());
+    eye->setDataVariance(osg::Object::DYNAMIC);
 
     osg::ref_ptr<osg::Geode> geode = new osg::Geode();
     geode->addDrawable(geom);
-
-    osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D();
-    texture->setImage(createColorImage());
-    texture->setWrap(osg::Texture::WRAP_S, osg::Texture::REPEAT);
-    texture->setWrap(osg::Texture::WRAP_T, osg::Texture::REPEAT);
-
-    geode->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+    geode->setCullCallback(new GroundEyeCallback(eye.get()));
+
+    // groundEye changes every cull; DYNAMIC holds the next frame back until
+    // the previous draw is done with it
+    osg::StateSet* ss = geode->getOrCreateStateSet();
+    ss->setDataVariance(osg::Object::DYNAMIC);
+    ss->setAttributeAndModes(program);
+    ss->addUniform(eye.get());
+    ss->addUniform(new osg::Uniform("gridSpacing", osg::Vec2(MINOR_SPACING, MAJOR_SPACING)));
+    ss->addUniform(new osg::Uniform("groundColor", osg::Vec3(0.6f, 0.6f, 0.6f)));
+    ss->addUniform(new osg::Uniform("lineColor", osg::Vec3(0.2f, 0.2f, 0.2f)));
+    ss->addUniform(new osg::Uniform("fadeDistance", 5000.0f));
+    ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    // Hits beyond the far plane are clamped to depth 1 and must still pass
+    ss->setAttributeAndModes(new osg::Depth(osg::Depth::LEQUAL));
 
     return geode;
 }
 
-// ---------- Callback to move ground under camera ----------
-class GroundFollowCallback : public osg::NodeCallback
-{
-public:
-    GroundFollowCallback(osg::MatrixTransform* ground, osg::Camera* cam)
-        : _ground(ground), _camera(cam) {}
-
-    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
-    {
-        if (!_camera.valid() || !_ground.valid()) return;
-
-        osg::Vec3 eye, center, up;
-        _camera->getViewMatrixAsLookAt(eye, center, up);
-
-        osg::Matrix mat = osg::Matrix::translate(osg::Vec3(eye.x(), 0.0, eye.z()));
-        _ground->setMatrix(mat);
-
-        traverse(node, nv);
-    }
-
-private:
-    osg::ref_ptr<osg::MatrixTransform> _ground;
-    osg::observer_ptr<osg::Camera> _camera;
-};
-
 // ---------- Main ----------
 int main()
 {
     osgViewer::Viewer viewer;
 
-    // Create ground
-    osg::ref_ptr<osg::Geode> groundGeode = createGround(5000.0f);
-    osg::ref_ptr<osg::MatrixTransform> groundTransform = new osg::MatrixTransform();
-    groundTransform->addChild(groundGeode);
-
-    // Set camera manipulator
+    // Set camera manipulator; the ground has no bound to compute a home from
     osg::ref_ptr<osgGA::TrackballManipulator> manip = new osgGA::TrackballManipulator();
+    manip->setHomePosition(osg::Vec3(0.0f, 50.0f, 300.0f), osg::Vec3(), osg::Vec3(0.0f, 1.0f, 0.0f));
     viewer.setCameraManipulator(manip);
 
-    // Attach callback to move ground under camera
-    groundTransform->setUpdateCallback(new GroundFollowCallback(groundTransform, viewer.getCamera()));
-
     // Scene root
     osg::ref_ptr<osg::Group> root = new osg::Group();
-    root->addChild(groundTransform);
+    root->addChild(createGround());
 
     viewer.setSceneData(root);
     viewer.realize();
 
     return viewer.run();
-}
\ No newline at end of file
+}
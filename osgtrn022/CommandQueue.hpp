@@ -0,0 +1,83 @@
+#pragma once
+#include <osg/NodeCallback>
+#include <atomic>
+#include <functional>
+#include <utility>
+
+//
+// CommandQueue
+// ------------
+// Hands actions from ImGui panels to the update traversal.
+//
+// drawUi() runs on the draw thread, so a panel must not change the scene
+// graph or state the update callbacks own. Instead it post()s what should
+// happen. The queue is an update callback. The next update traversal runs
+// every posted command in posting order, then traverses the subgraph, so
+// the commands take effect before that frame's other update callbacks.
+//
+// post() is lock-free and safe from any number of threads. The update side
+// takes the whole pending list with one atomic exchange. A frame with
+// nothing posted costs a single exchange.
+//
+class CommandQueue : public osg::NodeCallback
+{
+public:
+    typedef std::function<void()> Command;
+
+    void post(Command command)
+    {
+        Entry *entry = new Entry{std::move(command), _head.load(std::memory_order_relaxed)};
+        while (!_head.compare_exchange_weak(entry->next, entry, std::memory_order_release,
+                                            std::memory_order_relaxed))
+            ;
+    }
+
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        Entry *entry = takeInOrder();
+        while (entry)
+        {
+            Entry *next = entry->next;
+            entry->command();
+            delete entry;
+            entry = next;
+        }
+        traverse(node, nv);
+    }
+
+protected:
+    ~CommandQueue()
+    {
+        Entry *entry = _head.exchange(nullptr);
+        while (entry)
+        {
+            Entry *next = entry->next;
+            delete entry;
+            entry = next;
+        }
+    }
+
+private:
+    struct Entry
+    {
+        Command command;
+        Entry *next;
+    };
+
+    // The list is pushed newest first; reverse it to run in posting order
+    Entry *takeInOrder()
+    {
+        Entry *pending = _head.exchange(nullptr, std::memory_order_acquire);
+        Entry *ordered = nullptr;
+        while (pending)
+        {
+            Entry *next = pending->next;
+            pending->next = ordered;
+            ordered = pending;
+            pending = next;
+        }
+        return ordered;
+    }
+
+    std::atomic<Entry *> _head{nullptr};
+};
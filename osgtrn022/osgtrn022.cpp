@@ -14,6 +14,8 @@
 #include <imgui_impl_opengl3.h>
 
 #include "OsgImGuiHandler.hpp"
+#include "GpuGrid.hpp"
+#include "CommandQueue.hpp"
 
 // ======================
 // ImGui + OSG Integration
@@ -39,68 +41,21 @@ public:
     }
 };
 
-// ======================
-// Cubic Grid Generator (points)
-// ======================
-class GridGenerator
-{
-public:
-    static osg::ref_ptr<osg::Geode> createCubicGrid(float spacing, int halfCount = 5)
-    {
-        osg::ref_ptr<osg::Geode> geode = new osg::Geode;
-        osg::ref_ptr<osg::Geometry> geom = new osg::Geometry;
-        osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
-
-        // Generate cubic grid of points
-        for (int x = -halfCount; x <= halfCount; ++x)
-        {
-            for (int y = -halfCount; y <= halfCount; ++y)
-            {
-                for (int z = -halfCount; z <= halfCount; ++z)
-                {
-                    vertices->push_back(osg::Vec3(x * spacing, y * spacing, z * spacing));
-                }
-            }
-        }
-
-        geom->setVertexArray(vertices);
-        geom->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
-
-        // Point color
-        osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array;
-        colors->push_back(osg::Vec4(0.2f, 0.7f, 1.0f, 1.0f)); // cyan-blue
-        geom->setColorArray(colors, osg::Array::BIND_OVERALL);
-
-        // Visual settings
-        osg::ref_ptr<osg::StateSet> ss = geom->getOrCreateStateSet();
-
-        // Disable lighting (so color is not affected by light)
-        ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
-
-        // Set point size (make visible)
-        osg::ref_ptr<osg::Point> point = new osg::Point;
-        point->setSize(3.0f);
-        ss->setAttributeAndModes(point, osg::StateAttribute::ON);
-
-        // Optional: disable depth test for always-visible points (can comment if not wanted)
-        // ss->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
-
-        geode->addDrawable(geom);
-        return geode;
-    }
-};
-
 // ======================
 // ImGui Controller
 // ======================
+// Spacing edits are posted to a CommandQueue on the root and applied in the
+// next update traversal, not from the draw thread drawUi() runs on
 class ImGuiDemo : public OsgImGuiHandler
 {
 public:
     ImGuiDemo(osg::Group *root)
-        : _root(root), _gridSpacing(1.0f), _lastSpacing(1.0f)
+        : _root(root), _commands(new CommandQueue), _gridSpacing(1.0f)
     {
-        _gridNode = GridGenerator::createCubicGrid(_gridSpacing);
+        // Cubic grid of points, generated on the GPU
+        _gridNode = new GpuGrid(5, _gridSpacing, osg::Vec4(0.2f, 0.7f, 1.0f, 1.0f)); // cyan-blue
         _root->addChild(_gridNode);
+        _root->addUpdateCallback(_commands.get());
     }
 
 protected:
@@ -108,14 +63,12 @@ protected:
     {
         ImGui::Begin("3D Grid Controller");
         ImGui::Text("Adjust cubic grid spacing:");
-        ImGui::SliderFloat("Spacing", &_gridSpacing, 0.5f, 5.0f, "%.1f");
-
-        if (std::fabs(_gridSpacing - _lastSpacing) > 0.001f)
+        // A uniform write; the grid is not rebuilt
+        if (ImGui::SliderFloat("Spacing", &_gridSpacing, 0.5f, 5.0f, "%.1f"))
         {
-            _root->removeChild(_gridNode);
-            _gridNode = GridGenerator::createCubicGrid(_gridSpacing);
-            _root->addChild(_gridNode);
-            _lastSpacing = _gridSpacing;
+            osg::ref_ptr<GpuGrid> grid = _gridNode;
+            const float spacing = _gridSpacing;
+            _commands->post([grid, spacing]() { grid->setSpacing(spacing); });
         }
 
         ImGui::End();
@@ -123,9 +76,9 @@ protected:
 
 private:
     osg::observer_ptr<osg::Group> _root;
-    osg::ref_ptr<osg::Node> _gridNode;
+    osg::ref_ptr<CommandQueue> _commands;
+    osg::ref_ptr<GpuGrid> _gridNode;
     float _gridSpacing;
-    float _lastSpacing;
 };
 
 // ======================
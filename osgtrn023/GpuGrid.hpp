@@ -0,0 +1,129 @@
+#pragma once
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Point>
+#include <osg/Program>
+#include <osg/Uniform>
+#include <algorithm>
+
+//
+// GpuGrid
+// -------
+// A cubic (2n+1)^3 grid of points centred on the origin, generated in the
+// vertex shader from gl_VertexID. The geometry has no vertex data: one
+// DrawArrays of (2n+1)^3 points, and the shader turns each index into a
+// grid cell through the gridSide / gridSpacing uniforms.
+//
+// setSpacing() is a uniform write and setHalfCount() changes the draw
+// count; neither allocates or rebuilds anything. The bounding box is
+// computed from the same two values.
+//
+class GpuGrid : public osg::Geode
+{
+public:
+    GpuGrid(int halfCount, float spacing, const osg::Vec4 &color, float pointSize = 3.0f)
+        : _halfCount(std::max(halfCount, 0)), _spacing(spacing)
+    {
+        _points = new osg::DrawArrays(GL_POINTS, 0, side() * side() * side());
+
+        osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array;
+        colors->push_back(color);
+
+        _geom = new osg::Geometry;
+        _geom->setUseDisplayList(false);
+        _geom->setDataVariance(osg::Object::DYNAMIC);
+        _geom->setColorArray(colors.get(), osg::Array::BIND_OVERALL);
+        _geom->addPrimitiveSet(_points.get());
+        _geom->setComputeBoundingBoxCallback(new GridBoundsCallback(this));
+        addDrawable(_geom.get());
+
+        buildState(pointSize);
+    }
+
+    int getHalfCount() const { return _halfCount; }
+    float getSpacing() const { return _spacing; }
+
+    void setHalfCount(int halfCount)
+    {
+        halfCount = std::max(halfCount, 0);
+        if (halfCount == _halfCount)
+            return;
+        _halfCount = halfCount;
+        _sideUniform->set(side());
+        _points->setCount(side() * side() * side());
+        _points->dirty();
+        _geom->dirtyBound();
+    }
+
+    void setSpacing(float spacing)
+    {
+        if (spacing == _spacing)
+            return;
+        _spacing = spacing;
+        _spacingUniform->set(_spacing);
+        _geom->dirtyBound();
+    }
+
+private:
+    int side() const { return 2 * _halfCount + 1; }
+
+    void buildState(float pointSize)
+    {
+        // Index order matches the old CPU loops: x outermost, z innermost
+        static const char *vertSrc =
+            "#version 130\n"
+            "uniform int gridSide;\n"
+            "uniform float gridSpacing;\n"
+            "void main()\n"
+            "{\n"
+            "    int x = gl_VertexID / (gridSide * gridSide);\n"
+            "    int y = (gl_VertexID / gridSide) % gridSide;\n"
+            "    int z = gl_VertexID % gridSide;\n"
+            "    vec3 p = (vec3(x, y, z) - float(gridSide / 2)) * gridSpacing;\n"
+            "    gl_Position = gl_ModelViewProjectionMatrix * vec4(p, 1.0);\n"
+            "    gl_FrontColor = gl_Color;\n"
+            "}\n";
+        static const char *fragSrc =
+            "#version 130\n"
+            "void main()\n"
+            "{\n"
+            "    gl_FragColor = gl_Color;\n"
+            "}\n";
+
+        osg::ref_ptr<osg::Program> program = new osg::Program;
+        program->addShader(new osg::Shader(osg::Shader::VERTEX, vertSrc));
+        program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragSrc));
+
+        _sideUniform = new osg::Uniform("gridSide", side());
+        _spacingUniform = new osg::Uniform("gridSpacing", _spacing);
+        _sideUniform->setDataVariance(osg::Object::DYNAMIC);
+        _spacingUniform->setDataVariance(osg::Object::DYNAMIC);
+
+        osg::StateSet *ss = getOrCreateStateSet();
+        ss->setAttributeAndModes(program.get(), osg::StateAttribute::ON);
+        ss->addUniform(_sideUniform.get());
+        ss->addUniform(_spacingUniform.get());
+        ss->setAttributeAndModes(new osg::Point(pointSize), osg::StateAttribute::ON);
+        ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    }
+
+    struct GridBoundsCallback : public osg::Drawable::ComputeBoundingBoxCallback
+    {
+        explicit GridBoundsCallback(GpuGrid *grid) : _grid(grid) {}
+
+        osg::BoundingBox computeBound(const osg::Drawable &) const override
+        {
+            const float extent = _grid->_halfCount * _grid->_spacing;
+            return osg::BoundingBox(-extent, -extent, -extent, extent, extent, extent);
+        }
+
+        GpuGrid *_grid;
+    };
+
+    int _halfCount;
+    float _spacing;
+    osg::ref_ptr<osg::Geometry> _geom;
+    osg::ref_ptr<osg::DrawArrays> _points;
+    osg::ref_ptr<osg::Uniform> _sideUniform;
+    osg::ref_ptr<osg::Uniform> _spacingUniform;
+};
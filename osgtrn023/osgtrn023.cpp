@@ -12,6 +12,8 @@
 #include <imgui_impl_opengl3.h>
 
 #include "OsgImGuiHandler.hpp"
+#include "GpuGrid.hpp"
+#include "CommandQueue.hpp"
 
 // ======================= ImGui Initialization ===========================
 class ImGuiInitOperation : public osg::Operation
@@ -27,36 +29,6 @@ public:
     }
 };
 
-// ======================= Grid Generator ===========================
-osg::ref_ptr<osg::Geode> createGridPoints(int gridCount, float spacing)
-{
-    osg::ref_ptr<osg::Geode> geode = new osg::Geode();
-    osg::ref_ptr<osg::Geometry> geom = new osg::Geometry();
-
-    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array();
-
-    for (int x = -gridCount; x <= gridCount; ++x)
-        for (int y = -gridCount; y <= gridCount; ++y)
-            for (int z = -gridCount; z <= gridCount; ++z)
-                vertices->push_back(osg::Vec3(x * spacing, y * spacing, z * spacing));
-
-    geom->setVertexArray(vertices);
-    geom->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
-
-    osg::ref_ptr<osg::Vec4Array> colors = new osg::Vec4Array();
-    colors->push_back(osg::Vec4(1.0, 1.0, 1.0, 1.0)); // white points
-    geom->setColorArray(colors, osg::Array::BIND_OVERALL);
-
-    osg::ref_ptr<osg::StateSet> ss = geode->getOrCreateStateSet();
-    osg::ref_ptr<osg::Point> pointSize = new osg::Point(3.0f);
-    ss->setAttribute(pointSize);
-    ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
-    ss->setMode(GL_DEPTH_TEST, osg::StateAttribute::ON);
-
-    geode->addDrawable(geom);
-    return geode;
-}
-
 // ======================= Axes Generator ===========================
 osg::ref_ptr<osg::Geode> createAxes(float length)
 {
@@ -99,49 +71,68 @@ osg::ref_ptr<osg::Geode> createAxes(float length)
 }
 
 // ======================= ImGui UI Handler ===========================
+// The grid and axes are built once; the sliders only change the grid's
+// count and spacing uniforms and the axes' scale. Those changes are posted
+// to a CommandQueue on the root and applied in the next update traversal,
+// never from the draw thread drawUi() runs on.
 class ImGuiDemo : public OsgImGuiHandler
 {
 public:
     ImGuiDemo(osg::Group* root)
-        : _root(root)
+        : _root(root), _commands(new CommandQueue)
     {
         _gridCount = 5;
         _spacing = 1.0f;
-        rebuildScene();
+
+        _gridTransform = new osg::MatrixTransform();
+
+        // Add axes first so they are always visible at origin
+        _axesScale = new osg::MatrixTransform();
+        _axesScale->setDataVariance(osg::Object::DYNAMIC);
+        _axesScale->addChild(createAxes(1.0f));
+        _gridTransform->addChild(_axesScale);
+
+        // Add cubic grid points
+        _grid = new GpuGrid(_gridCount, _spacing, osg::Vec4(1.0, 1.0, 1.0, 1.0)); // white points
+        _gridTransform->addChild(_grid);
+
+        _root->addChild(_gridTransform);
+        _root->addUpdateCallback(_commands.get());
+        updateGrid();
     }
 
 protected:
     void drawUi() override
     {
         ImGui::Begin("Grid Control");
-        ImGui::SliderInt("Grid count", &_gridCount, 1, 20);
-        ImGui::SliderFloat("Spacing", &_spacing, 0.5f, 5.0f);
-        if (ImGui::Button("Update Grid"))
-            rebuildScene();
+        bool changed = ImGui::SliderInt("Grid count", &_gridCount, 1, 20);
+        changed |= ImGui::SliderFloat("Spacing", &_spacing, 0.5f, 5.0f);
+        if (changed)
+            updateGrid();
+        ImGui::Text("%d points", (2 * _gridCount + 1) * (2 * _gridCount + 1) * (2 * _gridCount + 1));
         ImGui::End();
     }
 
-    void rebuildScene()
+    void updateGrid()
     {
-        std::cout << "rebuildScene()\n";
-
-        if (_gridTransform.valid())
-            _root->removeChild(_gridTransform);
-
-        _gridTransform = new osg::MatrixTransform();
-
-        // Add axes first so they are always visible at origin
-        _gridTransform->addChild(createAxes((_gridCount + 2) * _spacing));
-
-        // Add cubic grid points
-        _gridTransform->addChild(createGridPoints(_gridCount, _spacing));
-
-        _root->addChild(_gridTransform);
+        osg::ref_ptr<GpuGrid> grid = _grid;
+        osg::ref_ptr<osg::MatrixTransform> axesScale = _axesScale;
+        const int count = _gridCount;
+        const float spacing = _spacing;
+        _commands->post([grid, axesScale, count, spacing]()
+        {
+            grid->setHalfCount(count);
+            grid->setSpacing(spacing);
+            axesScale->setMatrix(osg::Matrix::scale(osg::Vec3(1, 1, 1) * ((count + 2) * spacing)));
+        });
     }
 
 private:
     osg::observer_ptr<osg::Group> _root;
+    osg::ref_ptr<CommandQueue> _commands;
     osg::ref_ptr<osg::MatrixTransform> _gridTransform;
+    osg::ref_ptr<osg::MatrixTransform> _axesScale;
+    osg::ref_ptr<GpuGrid> _grid;
     int _gridCount;
     float _spacing;
 };
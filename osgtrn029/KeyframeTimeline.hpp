@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//
+// KeyframeTimeline
+// ----------------
+// Checkpoints of a full simulation state taken at fixed timeline intervals.
+// Keyframe k holds the first state recorded with t in [k*interval, (k+1)*interval),
+// so seeking to any t is an index computation: restore the keyframe and
+// fast-forward the remaining (< interval) delta with the normal step function.
+//
+// State must be copyable and is expected to be small (counters, flags,
+// array sizes) - bulk data such as trail vertices stays append-only and is
+// truncated to the sizes stored in the restored state.
+//
+template <typename State>
+class KeyframeTimeline
+{
+public:
+    struct Keyframe
+    {
+        float t;
+        State state;
+    };
+
+    explicit KeyframeTimeline(float interval = 0.05f) : _interval(interval) {}
+
+    float interval() const { return _interval; }
+    size_t size() const { return _keys.size(); }
+
+    void clear() { _keys.clear(); }
+
+    // Records state at t when it is the first one in its slot
+    void checkpoint(float t, const State &state)
+    {
+        const size_t slot = slotOf(t);
+        if (slot < _keys.size())
+            return;
+        // Slots skipped by a large step reuse this state; seek() walks past them
+        while (_keys.size() <= slot)
+            _keys.push_back({t, state});
+    }
+
+    // Latest keyframe with time <= t, or nullptr if none was recorded yet
+    const Keyframe *seek(float t) const
+    {
+        if (_keys.empty())
+            return nullptr;
+        size_t slot = std::min(slotOf(t), _keys.size() - 1);
+        while (_keys[slot].t > t)
+        {
+            if (slot == 0)
+                return nullptr;
+            --slot;
+        }
+        return &_keys[slot];
+    }
+
+    // Drops every keyframe recorded after t (history ahead is being rewritten)
+    void truncate(float t)
+    {
+        while (!_keys.empty() && _keys.back().t > t)
+            _keys.pop_back();
+    }
+
+private:
+    size_t slotOf(float t) const
+    {
+        return t <= 0.0f ? 0 : static_cast<size_t>(std::floor(t / _interval));
+    }
+
+    float _interval;
+    std::vector<Keyframe> _keys;
+};
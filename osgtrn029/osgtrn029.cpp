@@ -9,9 +9,12 @@
 #include <osgDB/ReadFile>
 #include <osg/LineStipple>
 
+#include <atomic>
+
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "KeyframeTimeline.hpp"
 
 // ======================= Constants ===========================
 const osg::Quat MODEL_BASIS(-0.00622421, 0.713223, -0.700883, -0.0061165);
@@ -43,10 +46,14 @@ struct AnimationState
     double lastUpdateTime = 0.0;
 } gAnim;
 
+// Requests from the UI (draw thread), carried out by SimulationCallback in update
+std::atomic<bool> gResetRequested{false};
+std::atomic<float> gSeekTarget{-1.0f}; // < 0 when no seek is pending
+
 // ======================= Forward declarations ===========================
-struct TrajectoryCallback;
-TrajectoryCallback* gAircraftTrail = nullptr;
-TrajectoryCallback* gMissileTrail  = nullptr;
+struct TrajectoryTrail;
+TrajectoryTrail* gAircraftTrail = nullptr;
+TrajectoryTrail* gMissileTrail  = nullptr;
 
 
 // ======================= Trajectories ===========================
@@ -115,6 +122,7 @@ static osg::Quat frameAlignQuat(const osg::Vec3 &forward_world, const osg::Vec3
 }
 
 // ======================= Object Update Callback ===========================
+// Poses one entity for the current gAnim.t; time itself is advanced by SimulationCallback
 class ObjectUpdateCallback : public osg::NodeCallback
 {
 public:
@@ -126,13 +134,6 @@ public:
 
     void operator()(osg::Node *node, osg::NodeVisitor *nv) override
     {
-        if (gAnim.running && !gAnim.collided)
-        {
-            gAnim.t += gAnim.speed * 0.01f;
-            if (gAnim.t >= 1.0f)
-                gAnim.t = 1.0f;
-        }
-
         osg::Vec3 pos = isMissile ? missileTrajectory(gAnim.t) : aircraftTrajectory(gAnim.t);
         osg::Vec3 nextPos = isMissile ? missileTrajectory(std::min(gAnim.t + 0.01f, 1.0f)) : aircraftTrajectory(std::min(gAnim.t + 0.01f, 1.0f));
 
@@ -158,35 +159,19 @@ public:
         osg::Matrix M = osg::Matrix::rotate(finalRot) * osg::Matrix::translate(pos);
         mt->setMatrix(M);
 
-        // Simple collision detection
-        if (!isMissile)
-        {
-            osg::Vec3 mpos = missileTrajectory(gAnim.t);
-            if ((pos - mpos).length() < 2.0f && !gAnim.collided)
-            {
-                gAnim.collided = true;
-                gAnim.running = false;
-                std::cout << "Collision detected at ("
-                          << pos.x() << ", "
-                          << pos.y() << ", "
-                          << pos.z() << ")"
-                          << std::endl;
-            }
-        }
-
         traverse(node, nv);
     }
 };
 
-// ======================= Dynamic Trajectory Callback ===========================
-struct TrajectoryCallback : public osg::NodeCallback
+// ======================= Trajectory Trail ===========================
+// Append-only vertex list; keyframes remember its size and truncate back to it
+struct TrajectoryTrail : public osg::Referenced
 {
     osg::ref_ptr<osg::Vec3Array> vertices;
     osg::ref_ptr<osg::Geometry> geom;
-    osg::ref_ptr<osg::MatrixTransform> mt;
 
-    TrajectoryCallback(osg::Geometry *g, osg::MatrixTransform *m, const osg::Vec4 &color)
-        : geom(g), mt(m)
+    TrajectoryTrail(osg::Geometry *g, const osg::Vec4 &color)
+        : geom(g)
     {
         vertices = new osg::Vec3Array();
         geom->setVertexArray(vertices);
@@ -201,28 +186,158 @@ struct TrajectoryCallback : public osg::NodeCallback
         geom->setUseDisplayList(false);
     }
 
-    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    size_t size() const { return vertices->size(); }
+
+    void append(const osg::Vec3 &pos)
     {
-        osg::Vec3 pos = mt->getMatrix().getTrans();
         vertices->push_back(pos);
+        dirty();
+    }
+
+    void truncate(size_t count)
+    {
+        if (count < vertices->size())
+        {
+            vertices->resize(count);
+            dirty();
+        }
+    }
+
+    void clearTrail() { truncate(0); }
 
+private:
+    void dirty()
+    {
         osg::DrawArrays *da = dynamic_cast<osg::DrawArrays *>(geom->getPrimitiveSet(0));
         if (da)
             da->setCount(vertices->size());
 
-        geom->dirtyDisplayList();
+        vertices->dirty();
         geom->dirtyBound();
-        traverse(node, nv);
     }
+};
+
+// ======================= Simulation & Keyframes ===========================
+// Everything needed to resume the simulation from a given point in time
+struct SimSnapshot
+{
+    float t = 0.0f;
+    bool collided = false;
+    size_t aircraftTrailSize = 0;
+    size_t missileTrailSize = 0;
+};
+
+KeyframeTimeline<SimSnapshot> gKeyframes(0.05f);
 
-    void clearTrail()
+SimSnapshot captureSnapshot()
+{
+    SimSnapshot s;
+    s.t = gAnim.t;
+    s.collided = gAnim.collided;
+    s.aircraftTrailSize = gAircraftTrail ? gAircraftTrail->size() : 0;
+    s.missileTrailSize = gMissileTrail ? gMissileTrail->size() : 0;
+    return s;
+}
+
+void restoreSnapshot(const SimSnapshot &s)
+{
+    gAnim.t = s.t;
+    gAnim.collided = s.collided;
+    if (gAircraftTrail)
+        gAircraftTrail->truncate(s.aircraftTrailSize);
+    if (gMissileTrail)
+        gMissileTrail->truncate(s.missileTrailSize);
+}
+
+// One simulation step per frame. Both entity callbacks used to advance t by
+// speed * 0.01 every frame, so a single driver steps twice that to keep the
+// engagement at its original pace
+float frameStep()
+{
+    return gAnim.speed * 0.02f;
+}
+
+// Advances the simulation by dt: moves time, extends the trails, latches collision
+void stepSimulation(float dt)
+{
+    if (gAnim.collided || gAnim.t >= 1.0f)
+        return;
+
+    gAnim.t = std::min(gAnim.t + dt, 1.0f);
+
+    const osg::Vec3 apos = aircraftTrajectory(gAnim.t);
+    const osg::Vec3 mpos = missileTrajectory(gAnim.t);
+    if (gAircraftTrail)
+        gAircraftTrail->append(apos);
+    if (gMissileTrail)
+        gMissileTrail->append(mpos);
+
+    // Simple collision detection
+    if ((apos - mpos).length() < gAnim.collisionThreshold)
     {
-        vertices->clear();
-        osg::DrawArrays *da = dynamic_cast<osg::DrawArrays *>(geom->getPrimitiveSet(0));
-        if (da)
-            da->setCount(0);
-        geom->dirtyDisplayList();
-        geom->dirtyBound();
+        gAnim.collided = true;
+        gAnim.running = false;
+        std::cout << "Collision detected at ("
+                  << apos.x() << ", "
+                  << apos.y() << ", "
+                  << apos.z() << ")"
+                  << std::endl;
+    }
+
+    gKeyframes.checkpoint(gAnim.t, captureSnapshot());
+}
+
+void resetSimulation()
+{
+    gAnim.t = 0.0f;
+    gAnim.running = false;
+    gAnim.collided = false;
+    if (gAircraftTrail)
+    {
+        gAircraftTrail->clearTrail();
+        gAircraftTrail->append(aircraftTrajectory(0.0f));
+    }
+    if (gMissileTrail)
+    {
+        gMissileTrail->clearTrail();
+        gMissileTrail->append(missileTrajectory(0.0f));
+    }
+    gKeyframes.clear();
+    gKeyframes.checkpoint(0.0f, captureSnapshot());
+}
+
+// Restores the nearest keyframe at or before target and replays only the remaining delta
+void seekSimulation(float target)
+{
+    const auto *key = gKeyframes.seek(target);
+    if (!key)
+        return;
+
+    restoreSnapshot(key->state);
+    gKeyframes.truncate(gAnim.t);
+
+    const float step = frameStep();
+    while (gAnim.t < target && !gAnim.collided)
+        stepSimulation(std::min(step, target - gAnim.t));
+}
+
+// Drives the simulation once per update traversal, before entities are posed.
+// Resets and seeks requested by the UI are applied here too, since they
+// rewrite the trail geometry
+class SimulationCallback : public osg::NodeCallback
+{
+public:
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        if (gResetRequested.exchange(false))
+            resetSimulation();
+
+        const float seekT = gSeekTarget.exchange(-1.0f);
+        if (seekT >= 0.0f)
+            seekSimulation(seekT);
+        else if (gAnim.running)
+            stepSimulation(frameStep());
+        traverse(node, nv);
     }
 };
 
@@ -239,18 +354,27 @@ protected:
 
         ImGui::SameLine();
         if (ImGui::Button("Reset"))
+            gResetRequested = true;
+
+        ImGui::SliderFloat("Speed", &gAnim.speed, 0.05f, 1.0f, "%.2f");
+
+        // Scrubbing restores the nearest keyframe and fast-forwards the rest.
+        // Only the latest target of a frame is kept; the seek runs in update
+        static bool wasRunning = false;
+        const float pendingT = gSeekTarget;
+        float seekT = pendingT >= 0.0f ? pendingT : gAnim.t;
+        if (ImGui::SliderFloat("t (timeline)", &seekT, 0.0f, 1.0f, "%.3f"))
+            gSeekTarget = seekT;
+        if (ImGui::IsItemActivated())
         {
-            gAnim.t = 0.0f;
+            wasRunning = gAnim.running;
             gAnim.running = false;
-            gAnim.collided = false;
-            if (gAircraftTrail)
-                gAircraftTrail->clearTrail();
-            if (gMissileTrail)
-                gMissileTrail->clearTrail();
         }
+        if (ImGui::IsItemDeactivated())
+            gAnim.running = wasRunning && !gAnim.collided;
 
-        ImGui::SliderFloat("Speed", &gAnim.speed, 0.05f, 1.0f, "%.2f");
         ImGui::Text("Collision: %s", gAnim.collided ? "YES" : "NO");
+        ImGui::Text("Keyframes: %zu (every %.2f)", gKeyframes.size(), gKeyframes.interval());
         ImGui::End();
     }
 };
@@ -272,20 +396,19 @@ osg::ref_ptr<osg::MatrixTransform> createBox(
     return mt;
 }
 
-osg::ref_ptr<osg::Geode> createDynamicTrajectory(
-    osg::MatrixTransform *mt, const osg::Vec4 &color, bool isMissile)
+osg::ref_ptr<osg::Geode> createDynamicTrajectory(const osg::Vec4 &color, bool isMissile)
 {
     osg::ref_ptr<osg::Geometry> geom = new osg::Geometry();
     osg::ref_ptr<osg::Geode> geode = new osg::Geode();
     geode->addDrawable(geom);
 
-    auto *cb = new TrajectoryCallback(geom, mt, color);
-    mt->addUpdateCallback(cb);
+    auto *trail = new TrajectoryTrail(geom, color);
+    geode->setUserData(trail); // keeps the trail alive with its geode
 
     if (isMissile)
-        gMissileTrail = cb;
+        gMissileTrail = trail;
     else
-        gAircraftTrail = cb;
+        gAircraftTrail = trail;
 
     return geode;
 }
@@ -315,8 +438,12 @@ int main(int argc, char **argv)
     root->addChild(missile);
 
     // Trails
-    root->addChild(createDynamicTrajectory(aircraft, osg::Vec4(0, 1, 0, 1), false)); // green
-    root->addChild(createDynamicTrajectory(missile, osg::Vec4(1, 1, 0, 1), true));   // yellow
+    root->addChild(createDynamicTrajectory(osg::Vec4(0, 1, 0, 1), false)); // green
+    root->addChild(createDynamicTrajectory(osg::Vec4(1, 1, 0, 1), true));   // yellow
+
+    // Simulation driver (runs before the entity callbacks below it)
+    resetSimulation();
+    root->addUpdateCallback(new SimulationCallback);
 
     // Viewer
     osgViewer::Viewer viewer;
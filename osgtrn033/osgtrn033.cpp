@@ -15,6 +15,7 @@
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "Frames.hpp"
 
 // ======================= ANSI Color Codes ===========================
 #define ANSI_RESET "\033[0m"
@@ -48,62 +49,10 @@ struct AnimationState
     float speed = 0.25f;
 } gAnim;
 
-const osg::Vec3 WORLD_UP(0, 0, -1);
+const frame::Vec3<frame::Ned> WORLD_UP(0, 0, -1);
 
 // ======================= F-14 Basis Adjustment ===========================
-static osg::Quat makeF14Basis()
-{
-    osg::Matrix M(-1, 0, 0, 0,
-                  0, 0, 1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-    osg::Quat q;
-    q.set(M);
-    return q;
-}
-
-static osg::Quat makeF14Basis2()
-{
-    osg::Matrix M(1, 0, 0, 0,
-                  0, 0, -1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-
-    // osg::Quat r(-0.00622421, 0.713223, -0.700883, -0.0061165);
-    osg::Quat q;
-    q.set(M);
-
-    return q;
-}
-
-static osg::Matrix makeNedToOsgMatrix()
-{
-    // | 1  0  0  0 |
-    // | 0  0 -1  0 |
-    // | 0  1  0  0 |
-    // | 0  0  0  1 |
-    return osg::Matrix(1, 0, 0, 0,
-                       0, 0, -1, 0,
-                       0, 1, 0, 0,
-                       0, 0, 0, 1);
-}
-
-static osg::Quat makeOrientationNedToOsgMatrix()
-{
-    // | 1  0  0  0 |
-    // | 0  0 -1  0 |
-    // | 0  1  0  0 |
-    // | 0  0  0  1 |
-    osg::Matrix M(1, 0, 0, 0,
-                  0, 0, -1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-
-    osg::Quat q;
-    q.set(M);
-
-    return q;
-}
+// NED/ENU/OSG and model display frame conversions are in Frames.hpp
 
 // const osg::Quat F14_BASIS =
 //     osg::Quat(osg::PI, osg::Vec3(0, 0, 1)) *
@@ -111,8 +60,6 @@ static osg::Quat makeOrientationNedToOsgMatrix()
 
 const osg::Quat F14_BASIS(-0.00622421, 0.713223, -0.700883, -0.0061165);
 
-// const osg::Quat F14_BASIS = makeF14Basis();
-
 // ======================= Trajectory ===========================
 static inline float easeCos01(float t)
 {
@@ -141,13 +88,15 @@ osg::Vec3 aircraftTrajectory(float t)
 }
 
 // ======================= Orientation Helpers ===========================
-static osg::Quat orientationFromTangent(const osg::Vec3 &forward, const osg::Vec3 &up)
+// Columns of R are the body axes, so the result maps NED -> body
+static frame::Quat<frame::Ned> orientationFromTangent(const frame::Vec3<frame::Ned> &forward,
+                                                      const frame::Vec3<frame::Ned> &up)
 {
-    osg::Vec3 X = forward;
+    osg::Vec3 X = forward.raw();
     X.normalize();
 
     // In NED, body +Z is down, so invert this vector
-    osg::Vec3 Z = -(up - X * (up * X));
+    osg::Vec3 Z = -(up.raw() - X * (up.raw() * X));
     Z.normalize();
 
     // Right-hand rule: Y = Z × X
@@ -177,7 +126,7 @@ static osg::Quat orientationFromTangent(const osg::Vec3 &forward, const osg::Vec
     osg::Quat q;
     q.set(R);
 
-    return q;
+    return frame::Quat<frame::Ned>(q);
 }
 
 // ======================= Debug Axes ===========================
@@ -330,7 +279,7 @@ public:
 
         osg::Vec3 fwd = p2 - p1;
         fwd.normalize();
-        osg::Quat orient = orientationFromTangent(fwd, WORLD_UP);
+        osg::Quat orient = orientationFromTangent(frame::Vec3<frame::Ned>(fwd), WORLD_UP).raw();
 
         osg::Quat finalRot = orient * F14_BASIS;
 
@@ -15,6 +15,7 @@
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "Frames.hpp"
 
 // ======================= ANSI Color Codes ===========================
 // #define ANSI_RESET "\033[0m"
@@ -58,62 +59,10 @@ struct AnimationState
     float speed = 0.25f;
 } gAnim;
 
-const osg::Vec3 WORLD_UP(0, 0, -1);
+const frame::Vec3<frame::Ned> WORLD_UP(0, 0, -1);
 
 // ======================= F-14 Basis Adjustment ===========================
-static osg::Quat makeF14Basis()
-{
-    osg::Matrix M(-1, 0, 0, 0,
-                  0, 0, 1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-    osg::Quat q;
-    q.set(M);
-    return q;
-}
-
-static osg::Quat makeF14Basis2()
-{
-    osg::Matrix M(1, 0, 0, 0,
-                  0, 0, -1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-
-    // osg::Quat r(-0.00622421, 0.713223, -0.700883, -0.0061165);
-    osg::Quat q;
-    q.set(M);
-
-    return q;
-}
-
-static osg::Matrix makeNedToOsgMatrix()
-{
-    // | 1  0  0  0 |
-    // | 0  0 -1  0 |
-    // | 0  1  0  0 |
-    // | 0  0  0  1 |
-    return osg::Matrix(1, 0, 0, 0,
-                       0, 0, -1, 0,
-                       0, 1, 0, 0,
-                       0, 0, 0, 1);
-}
-
-static osg::Quat makeOrientationNedToOsgMatrix()
-{
-    // | 1  0  0  0 |
-    // | 0  0 -1  0 |
-    // | 0  1  0  0 |
-    // | 0  0  0  1 |
-    osg::Matrix M(1, 0, 0, 0,
-                  0, 0, -1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-
-    osg::Quat q;
-    q.set(M);
-
-    return q;
-}
+// NED/ENU/OSG and model display frame conversions are in Frames.hpp
 
 // const osg::Quat F14_BASIS =
 //     osg::Quat(osg::PI, osg::Vec3(0, 0, 1)) *
@@ -228,13 +177,15 @@ osg::Vec3 aircraftTrajectory(float t)
 
 
 // ======================= Orientation Helpers ===========================
-static osg::Quat orientationFromTangent(const osg::Vec3 &forward, const osg::Vec3 &up)
+// Body (x nose, y right, z down) attitude in NED, shown in the F-14 display frame
+static frame::Quat<frame::F14Display> orientationFromTangent(const frame::Vec3<frame::Ned> &forward,
+                                                             const frame::Vec3<frame::Ned> &up)
 {
-    osg::Vec3 X = forward;
+    osg::Vec3 X = forward.raw();
     X.normalize();
 
     // In NED, body +Z is down, so invert this vector
-    osg::Vec3 Z = -(up - X * (up * X));
+    osg::Vec3 Z = -(up.raw() - X * (up.raw() * X));
     Z.normalize();
 
     // Right-hand rule: Y = Z × X
@@ -261,14 +212,10 @@ static osg::Quat orientationFromTangent(const osg::Vec3 &forward, const osg::Vec
                   X.z(), Y.z(), Z.z(), 0.0f,
                   0.0f, 0.0f, 0.0f, 1.0f);
 
-    auto rotX = R.getRotate().x();
-    auto rotY = R.getRotate().y();
-    auto rotZ = R.getRotate().z();
-    auto rotW = R.getRotate().w();
-
-    osg::Quat q(rotX, rotZ, rotY, rotW);
-
-    return q;
+    // R maps NED -> body, so body -> NED is its conjugate; the display frame
+    // swap is resolved at compile time
+    const frame::Quat<frame::Ned> attitude(R.getRotate().conj());
+    return frame::convert<frame::F14Display>(attitude);
 }
 
 // ======================= Debug Axes ===========================
@@ -422,7 +369,7 @@ public:
             if (fwd.length2() < 1e-8f)
                 fwd = p1 - p0;
             fwd.normalize();
-            osg::Quat orient = orientationFromTangent(fwd, WORLD_UP);
+            osg::Quat orient = orientationFromTangent(frame::Vec3<frame::Ned>(fwd), WORLD_UP).raw();
 
             osg::Quat finalRot = orient * F14_BASIS;
 
@@ -0,0 +1,161 @@
+#pragma once
+#include <osg/Matrix>
+#include <osg/Quat>
+#include <osg/Vec3>
+
+//
+// Frames
+// ------
+// Tagged vectors and rotations per coordinate frame. Every frame used in
+// these lessons is a signed permutation of NED axes, so any conversion is
+// a compile-time table of (source axis, sign) per component:
+//
+//   convert<Enu>(Vec3<Ned>)   ->  (e, n, -d)       three moves, one negate
+//   convert<Ned>(Vec3<Ned>)   ->  no-op
+//
+// Mixing frames without convert<> does not compile.
+//
+// Rotations convert as R' = S R S^T. For a quaternion that is
+//   xyz' = det(S) * S * xyz,   w' = w
+// so mirrored frames (det = -1, e.g. the model display frames below) are
+// handled by the same rule instead of hand-written component swaps.
+//
+namespace frame
+{
+    // out[i] = sign[i] * in[axis[i]], relative to NED
+    struct Axes
+    {
+        int axis[3];
+        int sign[3];
+    };
+
+    // World frames
+    struct Ned // x north, y east, z down
+    {
+        static constexpr Axes fromNed{{0, 1, 2}, {1, 1, 1}};
+    };
+    struct Enu // x east, y north, z up
+    {
+        static constexpr Axes fromNed{{1, 0, 2}, {1, 1, -1}};
+    };
+    struct Osg // OSG Z-up world: x east, y north, z up
+    {
+        static constexpr Axes fromNed{{1, 0, 2}, {1, 1, -1}};
+    };
+
+    // Display frames the lesson models are oriented in (mirrors of NED)
+    struct F14Display // y and z swapped
+    {
+        static constexpr Axes fromNed{{0, 2, 1}, {1, 1, 1}};
+    };
+    struct MissileDisplay // z flipped
+    {
+        static constexpr Axes fromNed{{0, 1, 2}, {1, 1, -1}};
+    };
+
+    constexpr Axes inverse(const Axes &a)
+    {
+        Axes r{{0, 0, 0}, {1, 1, 1}};
+        for (int i = 0; i < 3; ++i)
+        {
+            r.axis[a.axis[i]] = i;
+            r.sign[a.axis[i]] = a.sign[i];
+        }
+        return r;
+    }
+
+    // first a, then b
+    constexpr Axes compose(const Axes &a, const Axes &b)
+    {
+        Axes r{{0, 0, 0}, {1, 1, 1}};
+        for (int i = 0; i < 3; ++i)
+        {
+            r.axis[i] = a.axis[b.axis[i]];
+            r.sign[i] = b.sign[i] * a.sign[b.axis[i]];
+        }
+        return r;
+    }
+
+    constexpr int determinant(const Axes &a)
+    {
+        int d = a.sign[0] * a.sign[1] * a.sign[2];
+        for (int i = 0; i < 3; ++i)
+            for (int j = i + 1; j < 3; ++j)
+                if (a.axis[i] > a.axis[j])
+                    d = -d;
+        return d;
+    }
+
+    template <class From, class To>
+    constexpr Axes mapping() { return compose(inverse(From::fromNed), To::fromNed); }
+
+    // ======================= Tagged types ===========================
+    template <class F>
+    class Vec3
+    {
+    public:
+        Vec3() = default;
+        explicit Vec3(const osg::Vec3 &v) : _v(v) {}
+        Vec3(float x, float y, float z) : _v(x, y, z) {}
+
+        const osg::Vec3 &raw() const { return _v; }
+
+        Vec3 operator+(const Vec3 &o) const { return Vec3(_v + o._v); }
+        Vec3 operator-(const Vec3 &o) const { return Vec3(_v - o._v); }
+        Vec3 operator*(float s) const { return Vec3(_v * s); }
+        float operator*(const Vec3 &o) const { return _v * o._v; }
+        Vec3 operator^(const Vec3 &o) const { return Vec3(_v ^ o._v); }
+        float length() const { return _v.length(); }
+
+    private:
+        osg::Vec3 _v;
+    };
+
+    // Rotation expressed in frame F
+    template <class F>
+    class Quat
+    {
+    public:
+        Quat() = default;
+        explicit Quat(const osg::Quat &q) : _q(q) {}
+
+        const osg::Quat &raw() const { return _q; }
+
+        Quat operator*(const Quat &o) const { return Quat(_q * o._q); }
+        Vec3<F> operator*(const Vec3<F> &v) const { return Vec3<F>(_q * v.raw()); }
+        Quat conj() const { return Quat(_q.conj()); }
+
+    private:
+        osg::Quat _q;
+    };
+
+    // ======================= Conversions ===========================
+    template <class To, class From>
+    Vec3<To> convert(const Vec3<From> &v)
+    {
+        constexpr Axes m = mapping<From, To>();
+        const osg::Vec3 &a = v.raw();
+        return Vec3<To>(m.sign[0] * a[m.axis[0]], m.sign[1] * a[m.axis[1]], m.sign[2] * a[m.axis[2]]);
+    }
+
+    template <class To, class From>
+    Quat<To> convert(const Quat<From> &q)
+    {
+        constexpr Axes m = mapping<From, To>();
+        constexpr int d = determinant(m);
+        const osg::Quat &a = q.raw();
+        return Quat<To>(osg::Quat(d * m.sign[0] * a[m.axis[0]], d * m.sign[1] * a[m.axis[1]],
+                                  d * m.sign[2] * a[m.axis[2]], a.w()));
+    }
+
+    // Row-vector matrix (v * M) of the same conversion, for scene graph transforms
+    template <class From, class To>
+    osg::Matrix matrix()
+    {
+        constexpr Axes m = mapping<From, To>();
+        osg::Matrix M(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1);
+        for (int i = 0; i < 3; ++i)
+            M(m.axis[i], i) = m.sign[i];
+        return M;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <osg/Quat>
+#include <osg/Vec3>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+//
+// OrientationKernel
+// -----------------
+// Body attitude (x nose, y right, z down) from a flight direction and the
+// world up vector, written straight into a quaternion. The basis is built
+// in registers and converted with Shepperd's method: of the four terms
+//   1 + m00 + m11 + m22,  1 + m00 - m11 - m22, ...
+// the largest picks which component is taken from a square root, and the
+// other three follow from sums/differences of off-diagonal terms. The
+// choice is made with selects, not branches, and costs a single sqrt.
+// There is no osg::Matrix and no getRotate() call.
+//
+// The batch form takes structure-of-arrays input and has no branches in
+// the loop body, so the compiler can vectorize it across entities (needs
+// -O3 plus -fno-math-errno -fno-trapping-math, both implied by -ffast-math;
+// without them GCC keeps the compares as branches and the loop scalar).
+//
+// Vertical flight: when the nose is (anti)parallel to up, the projection
+// of up used for the belly vanishes. The kernel then takes the belly from
+// `hint` instead (an alternative up, not parallel to up), so the result
+// stays finite and does not flip while climbing straight up.
+//
+namespace orientation
+{
+    // Outputs are quaternion components, one array each; they must not
+    // overlap the inputs (__restrict spares the compiler alias checks)
+    inline void attitudesFromTangents(size_t count, const float *fx, const float *fy, const float *fz,
+                                      const osg::Vec3 &up, const osg::Vec3 &hint,
+                                      float *__restrict qx, float *__restrict qy,
+                                      float *__restrict qz, float *__restrict qw)
+    {
+        const float ux = up.x(), uy = up.y(), uz = up.z();
+        const float hx = hint.x(), hy = hint.y(), hz = hint.z();
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            // X: nose
+            const float n = 1.0f / std::sqrt(fx[i] * fx[i] + fy[i] * fy[i] + fz[i] * fz[i] + 1e-30f);
+            const float xx = fx[i] * n, xy = fy[i] * n, xz = fz[i] * n;
+
+            // Z: belly, i.e. minus up with its nose component removed
+            const float du = ux * xx + uy * xy + uz * xz;
+            const float dh = hx * xx + hy * xy + hz * xz;
+            float zx = xx * du - ux, zy = xy * du - uy, zz = xz * du - uz;
+            const float bx = xx * dh - hx, by = xy * dh - hy, bz = xz * dh - hz;
+            const float v = zx * zx + zy * zy + zz * zz < 1e-6f ? 1.0f : 0.0f; // vertical
+            zx += v * (bx - zx);
+            zy += v * (by - zy);
+            zz += v * (bz - zz);
+            const float m = 1.0f / std::sqrt(zx * zx + zy * zy + zz * zz + 1e-30f);
+            zx *= m;
+            zy *= m;
+            zz *= m;
+
+            // Y: right wing, Z x X
+            const float yx = zy * xz - zz * xy;
+            const float yy = zz * xx - zx * xz;
+            const float yz = zx * xy - zy * xx;
+
+            // Basis columns are X, Y, Z: m00 = xx, m10 = xy, m01 = yx, ...
+            const float tw = 1.0f + xx + yy + zz;
+            const float tx = 1.0f + xx - yy - zz;
+            const float ty = 1.0f - xx + yy - zz;
+            const float tz = 1.0f - xx - yy + zz;
+            const float t = std::max(std::max(tw, tx), std::max(ty, tz));
+            // One-hot case weights, exact 0/1 so the blend below is a select
+            const float cw = t == tw ? 1.0f : 0.0f;
+            const float cx = (1.0f - cw) * (t == tx ? 1.0f : 0.0f);
+            const float cy = (1.0f - cw - cx) * (t == ty ? 1.0f : 0.0f);
+            const float cz = 1.0f - cw - cx - cy;
+            const float s = 0.5f / std::sqrt(t);
+
+            qw[i] = s * (cw * tw + cx * (yz - zy) + cy * (zx - xz) + cz * (xy - yx));
+            qx[i] = s * (cw * (yz - zy) + cx * tx + cy * (xy + yx) + cz * (zx + xz));
+            qy[i] = s * (cw * (zx - xz) + cx * (xy + yx) + cy * ty + cz * (yz + zy));
+            qz[i] = s * (cw * (xy - yx) + cx * (zx + xz) + cy * (yz + zy) + cz * tz);
+        }
+    }
+
+    // Single entity; same math as the batch
+    inline osg::Quat attitudeFromTangent(const osg::Vec3 &forward, const osg::Vec3 &up,
+                                         const osg::Vec3 &hint = osg::Vec3(1.0f, 0.0f, 0.0f))
+    {
+        const float fx = forward.x(), fy = forward.y(), fz = forward.z();
+        float x, y, z, w;
+        attitudesFromTangents(1, &fx, &fy, &fz, up, hint, &x, &y, &z, &w);
+        return osg::Quat(x, y, z, w);
+    }
+}
@@ -15,6 +15,9 @@
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "Frames.hpp"
+#include "OrientationKernel.hpp"
+#include "TrailHistory.hpp"
 
 // ======================= ANSI Color Codes ===========================
 // #define ANSI_RESET "\033[0m"
@@ -60,62 +63,10 @@ struct AnimationState
 
 float gTailOffset = 24.0f;
 
-const osg::Vec3 WORLD_UP(0, 0, -1);
+const frame::Vec3<frame::Ned> WORLD_UP(0, 0, -1);
 
 // ======================= F-14 Basis Adjustment ===========================
-static osg::Quat makeF14Basis()
-{
-    osg::Matrix M(-1, 0, 0, 0,
-                  0, 0, 1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-    osg::Quat q;
-    q.set(M);
-    return q;
-}
-
-static osg::Quat makeF14Basis2()
-{
-    osg::Matrix M(1, 0, 0, 0,
-                  0, 0, -1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-
-    // osg::Quat r(-0.00622421, 0.713223, -0.700883, -0.0061165);
-    osg::Quat q;
-    q.set(M);
-
-    return q;
-}
-
-static osg::Matrix makeNedToOsgMatrix()
-{
-    // | 1  0  0  0 |
-    // | 0  0 -1  0 |
-    // | 0  1  0  0 |
-    // | 0  0  0  1 |
-    return osg::Matrix(1, 0, 0, 0,
-                       0, 0, -1, 0,
-                       0, 1, 0, 0,
-                       0, 0, 0, 1);
-}
-
-static osg::Quat makeOrientationNedToOsgMatrix()
-{
-    // | 1  0  0  0 |
-    // | 0  0 -1  0 |
-    // | 0  1  0  0 |
-    // | 0  0  0  1 |
-    osg::Matrix M(1, 0, 0, 0,
-                  0, 0, -1, 0,
-                  0, 1, 0, 0,
-                  0, 0, 0, 1);
-
-    osg::Quat q;
-    q.set(M);
-
-    return q;
-}
+// NED/ENU/OSG and model display frame conversions are in Frames.hpp
 
 // const osg::Quat F14_BASIS =
 //     osg::Quat(osg::PI, osg::Vec3(0, 0, 1)) *
@@ -229,24 +180,20 @@ osg::Vec3 aircraftTrajectory(float t)
 }
 
 // ======================= Orientation Helpers ===========================
-static osg::Quat orientationFromTangent(const osg::Vec3 &forward, const osg::Vec3 &up)
+// Body (x nose, y right, z down) attitude in NED, shown in the F-14 display frame
+static frame::Quat<frame::F14Display> orientationFromTangent(const frame::Vec3<frame::Ned> &forward,
+                                                             const frame::Vec3<frame::Ned> &up)
 {
-    osg::Vec3 X = forward;
-    X.normalize();
-
-    // In NED, body +Z is down, so invert this vector
-    osg::Vec3 Z = -(up - X * (up * X));
-    Z.normalize();
-
-    // Right-hand rule: Y = Z × X
-    osg::Vec3 Y = Z ^ X;
-    Y.normalize();
+    const frame::Quat<frame::Ned> attitude(orientation::attitudeFromTangent(forward.raw(), up.raw()));
 
     if (gAnim.logging)
     {
         static int frameCount = 0;
         if (frameCount % 10 == 0)
         {
+            const osg::Vec3 X = attitude.raw() * osg::Vec3(1, 0, 0);
+            const osg::Vec3 Y = attitude.raw() * osg::Vec3(0, 1, 0);
+            const osg::Vec3 Z = attitude.raw() * osg::Vec3(0, 0, 1);
             std::cout << std::fixed << std::setprecision(6);
             std::cout << ANSI_CYAN << "\nBody axes in NED world:" << ANSI_RESET << "\n";
             std::cout << "  " << ANSI_RED << "+X (red, nose)  -> (" << X.x() << ", " << X.y() << ", " << X.z() << ")" << ANSI_RESET << "\n";
@@ -257,19 +204,7 @@ static osg::Quat orientationFromTangent(const osg::Vec3 &forward, const osg::Vec
         frameCount++;
     }
 
-    osg::Matrix R(X.x(), Y.x(), Z.x(), 0.0f,
-                  X.y(), Y.y(), Z.y(), 0.0f,
-                  X.z(), Y.z(), Z.z(), 0.0f,
-                  0.0f, 0.0f, 0.0f, 1.0f);
-
-    auto rotX = R.getRotate().x();
-    auto rotY = R.getRotate().y();
-    auto rotZ = R.getRotate().z();
-    auto rotW = R.getRotate().w();
-
-    osg::Quat q(rotX, rotZ, rotY, rotW);
-
-    return q;
+    return frame::convert<frame::F14Display>(attitude);
 }
 
 // ======================= Debug Axes ===========================
@@ -339,25 +274,31 @@ public:
 
     osg::Geode *geode() const { return _geode.get(); }
 
+    TrailHistory &history() { return _history; }
+
+    // Drops the visible trail and its recorded history
     void clear()
     {
+        _history.clear();
         _verts->clear();
-        _draw->setCount(0);
-        _geom->dirtyDisplayList();
-        _geom->dirtyBound();
-        _hasLast = false;
+        _shownT = 0.0f;
+        dirty();
     }
 
-    void addPoint(const osg::Vec3 &p)
+    // Appends a point recorded at timeline position t
+    void addPoint(float t, const osg::Vec3 &p)
     {
-        if (_hasLast)
+        if (t < _shownT)
+            scrubTo(t);
+        _shownT = t;
+
+        if (!_verts->empty())
         {
-            if ((p - _last).length() < _minSegment)
+            if ((p - _verts->back()).length() < _minSegment)
                 return;
         }
+        _history.record(t, p);
         _verts->push_back(p);
-        _last = p;
-        _hasLast = true;
 
         if (_verts->size() > _maxPoints)
         {
@@ -365,21 +306,38 @@ public:
             _verts->erase(_verts->begin(), _verts->begin() + overflow);
         }
 
+        dirty();
+    }
+
+    // Rebuilds the visible trail as it was at timeline position t
+    void scrubTo(float t)
+    {
+        if (t == _shownT)
+            return;
+        _history.slice(t, _maxPoints, _verts.get());
+        _shownT = t;
+        dirty();
+    }
+
+private:
+    void dirty()
+    {
         _draw->setCount(_verts->size());
+        _verts->dirty();
         _geom->dirtyDisplayList();
         _geom->dirtyBound();
     }
 
-private:
     osg::ref_ptr<osg::Geode> _geode;
     osg::ref_ptr<osg::Geometry> _geom;
     osg::ref_ptr<osg::Vec3Array> _verts;
     osg::ref_ptr<osg::DrawArrays> _draw;
 
+    TrailHistory _history;
+    float _shownT = 0.0f;
+
     size_t _maxPoints;
     float _minSegment;
-    bool _hasLast = false;
-    osg::Vec3 _last;
 };
 
 // ======================= F-14 Motion Callback ===========================
@@ -427,17 +385,24 @@ public:
             fwd = p1 - p0;
         fwd.normalize();
 
-        osg::Quat orient = orientationFromTangent(fwd, WORLD_UP);
+        osg::Quat orient = orientationFromTangent(frame::Vec3<frame::Ned>(fwd), WORLD_UP).raw();
         osg::Quat finalRot = orient * F14_BASIS;
 
         mt->setMatrix(osg::Matrix::rotate(finalRot) * osg::Matrix::translate(p1));
 
-        // Only leave a trail when running (scrubbing won't paint lines)
+        // Only leave a trail when running; scrubbing replays the recorded history
         if (_trail.valid())
         {
-            osg::Vec3 worldForward = finalRot * osg::Vec3(1, 0, 0);
-            osg::Vec3 tailPoint = p1 - worldForward * gTailOffset; // gTailOffset should be POSITIVE distance; sign handled here
-            _trail->addPoint(tailPoint);
+            if (gAnim.running)
+            {
+                osg::Vec3 worldForward = finalRot * osg::Vec3(1, 0, 0);
+                osg::Vec3 tailPoint = p1 - worldForward * gTailOffset; // gTailOffset should be POSITIVE distance; sign handled here
+                _trail->addPoint(gAnim.t, tailPoint);
+            }
+            else
+            {
+                _trail->scrubTo(gAnim.t);
+            }
         }
 
         traverse(mt.get(), nv);
@@ -487,9 +452,15 @@ protected:
                           << std::endl;
                 gAnim.logging = false;
             }
+            std::cout << ANSI_CYAN << "=== Reset motion (trail history kept) ===" << ANSI_RESET << std::endl;
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Trail"))
+        {
             if (_trail.valid())
                 _trail->clear();
-            std::cout << ANSI_CYAN << "=== Reset motion & trail ===" << ANSI_RESET << std::endl;
+            std::cout << ANSI_CYAN << "=== Trail cleared ===" << ANSI_RESET << std::endl;
         }
 
         ImGui::SliderFloat("Speed", &gAnim.speed, 0.05f, 1.0f, "%.2f");
@@ -507,13 +478,9 @@ protected:
                 wasRunning = gAnim.running;
                 gAnim.running = false;
             }
-            // Clear trail after scrub to avoid discontinuity
+            // The trail follows the scrub from its history; resuming overwrites what lies ahead
             if (ImGui::IsItemDeactivatedAfterEdit())
-            {
-                if (_trail.valid())
-                    _trail->clear();
                 gAnim.running = wasRunning;
-            }
         }
 
         ImGui::SliderFloat("Tail Offset", &gTailOffset, -60.0f, 0.0f, "%.1f");
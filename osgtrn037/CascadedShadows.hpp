@@ -0,0 +1,432 @@
+#pragma once
+#include <osg/Camera>
+#include <osg/ColorMask>
+#include <osg/Group>
+#include <osg/LightSource>
+#include <osg/PolygonOffset>
+#include <osg/Program>
+#include <osg/Texture2D>
+#include <osg/Uniform>
+#include <osgUtil/CullVisitor>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//
+// CascadedShadowMap
+// -----------------
+// Cascaded shadow maps for the light of one osg::LightSource.
+//
+// The view frustum, from `nearDistance` to `maxDistance`, is split into up
+// to four cascades (blend of uniform and logarithmic splits). Each cascade
+// is fitted with the bounding sphere of its frustum slice. The sphere's
+// size does not change as the camera turns, and its centre is snapped to
+// whole shadow texels in light space, so shadow edges do not swim.
+//
+// Every cascade has two depth maps:
+// * static  - the static casters (terrain). The map covers the cascade
+//             sphere grown by `staticMargin` and is only re-rendered when the
+//             cascade leaves it, the light direction changes or the light
+//             is re-enabled. A camera moving within the margin costs nothing.
+// * dynamic - the moving casters (aircraft), rendered over the exact
+//             cascade at `dynamicRate` Hz (0 = every frame).
+// Frame cost is bounded by cascades x resolution for the dynamic casters,
+// which are small, plus an occasional static refresh.
+//
+// The caster cameras are culled from traverse(), not as children, so the
+// update traversal never reaches the casters twice. Receivers get a
+// per-pixel light-0 shader (addReceiver) that picks the cascade by eye
+// depth and takes the darker of the static and dynamic lookups (2x2 PCF).
+// A positional light is treated as directional per frame, shining from
+// its position towards the camera. The node belongs directly under the
+// root: cascades and casters are in world space.
+//
+class CascadedShadowMap : public osg::Group
+{
+public:
+    struct Settings
+    {
+        unsigned int cascades = 3;    // 1..4
+        unsigned int resolution = 2048;
+        float nearDistance = 1.0f;    // first split starts here
+        float maxDistance = 1000.0f;  // no shadows beyond
+        float splitLambda = 0.75f;    // 0 uniform .. 1 logarithmic
+        double dynamicRate = 0.0;     // Hz, 0 = every frame
+        float staticMargin = 0.5f;    // static map radius = cascade radius * (1 + margin)
+    };
+
+    CascadedShadowMap(osg::LightSource *light, const Settings &settings = Settings())
+        : _light(light), _settings(settings)
+    {
+        _settings.cascades = std::min(std::max(_settings.cascades, 1u), 4u);
+        _staticCasters = new osg::Group;
+        _dynamicCasters = new osg::Group;
+        buildCascades();
+        buildState();
+    }
+
+    const Settings &settings() const { return _settings; }
+
+    // Casters are also added as children, so they are drawn normally
+    void addStaticCaster(osg::Node *node)
+    {
+        _staticCasters->addChild(node);
+        if (!containsNode(node))
+            addChild(node);
+        _staticValid = false;
+    }
+
+    void addDynamicCaster(osg::Node *node)
+    {
+        _dynamicCasters->addChild(node);
+        if (!containsNode(node))
+            addChild(node);
+    }
+
+    // Shades `node` with the shadow receiver program (light 0, texture unit 0)
+    void addReceiver(osg::Node *node)
+    {
+        node->getOrCreateStateSet()->setAttributeAndModes(_receiverProgram.get(), osg::StateAttribute::ON);
+    }
+
+    // Forces the static maps to be rendered again, e.g. after the terrain changed
+    void dirtyStatic() { _staticValid = false; }
+
+    unsigned int staticRenders() const { return _staticRenders; }
+
+    void traverse(osg::NodeVisitor &nv) override
+    {
+        osgUtil::CullVisitor *cv = nv.getVisitorType() == osg::NodeVisitor::CULL_VISITOR
+                                       ? static_cast<osgUtil::CullVisitor *>(&nv)
+                                       : nullptr;
+        if (!cv)
+        {
+            osg::Group::traverse(nv);
+            return;
+        }
+
+        cullCasters(*cv);
+        // Pushed after the casters so the caster cameras do not sample the
+        // maps they render into
+        cv->pushStateSet(_shadowState.get());
+        osg::Group::traverse(nv);
+        cv->popStateSet();
+    }
+
+private:
+    struct Cascade
+    {
+        osg::ref_ptr<osg::Camera> staticCamera, dynamicCamera;
+        osg::ref_ptr<osg::Texture2D> staticMap, dynamicMap;
+        osg::Vec3d staticCenter;
+        double staticRadius = 0.0;
+    };
+
+    bool containsNode(osg::Node *node) const { return getChildIndex(node) < getNumChildren(); }
+
+    osg::Texture2D *createDepthMap() const
+    {
+        osg::Texture2D *map = new osg::Texture2D;
+        map->setTextureSize(_settings.resolution, _settings.resolution);
+        map->setInternalFormat(GL_DEPTH_COMPONENT);
+        map->setSourceFormat(GL_DEPTH_COMPONENT);
+        map->setSourceType(GL_FLOAT);
+        map->setShadowComparison(true);
+        map->setShadowCompareFunc(osg::Texture::LEQUAL);
+        map->setShadowTextureMode(osg::Texture::LUMINANCE);
+        map->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        map->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        map->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_BORDER);
+        map->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_BORDER);
+        map->setBorderColor(osg::Vec4(1.0, 1.0, 1.0, 1.0));
+        return map;
+    }
+
+    osg::Camera *createCasterCamera(osg::Texture2D *map, osg::Node *casters) const
+    {
+        osg::Camera *camera = new osg::Camera;
+        camera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+        camera->setRenderOrder(osg::Camera::PRE_RENDER);
+        camera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
+        camera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
+        camera->setClearMask(GL_DEPTH_BUFFER_BIT);
+        camera->setViewport(0, 0, _settings.resolution, _settings.resolution);
+        camera->attach(osg::Camera::DEPTH_BUFFER, map);
+        camera->setStateSet(_casterState.get());
+        camera->addChild(casters);
+        return camera;
+    }
+
+    void buildCascades()
+    {
+        // Depth only: no colour, lighting, texturing or receiver shader
+        _casterState = new osg::StateSet;
+        const int overrideOff = osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE;
+        _casterState->setAttribute(new osg::ColorMask(false, false, false, false), osg::StateAttribute::OVERRIDE);
+        _casterState->setAttribute(new osg::Program, osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+        _casterState->setMode(GL_LIGHTING, overrideOff);
+        _casterState->setTextureMode(0, GL_TEXTURE_2D, overrideOff);
+        _casterState->setMode(GL_CULL_FACE, overrideOff);
+        _casterState->setAttributeAndModes(new osg::PolygonOffset(1.1f, 4.0f),
+                                           osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+
+        _cascades.resize(_settings.cascades);
+        for (Cascade &c : _cascades)
+        {
+            c.staticMap = createDepthMap();
+            c.dynamicMap = createDepthMap();
+            c.staticCamera = createCasterCamera(c.staticMap.get(), _staticCasters.get());
+            c.dynamicCamera = createCasterCamera(c.dynamicMap.get(), _dynamicCasters.get());
+        }
+    }
+
+    void buildState()
+    {
+        static const char *vertSrc =
+            "#version 120\n"
+            "uniform mat4 osg_ViewMatrixInverse;\n"
+            "varying vec3 eyePos;\n"
+            "varying vec3 eyeNormal;\n"
+            "varying vec4 worldPos;\n"
+            "void main()\n"
+            "{\n"
+            "    vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n"
+            "    eyePos = eye.xyz / eye.w;\n"
+            "    eyeNormal = gl_NormalMatrix * gl_Normal;\n"
+            "    worldPos = osg_ViewMatrixInverse * eye;\n"
+            "    gl_Position = ftransform();\n"
+            "    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+            "    gl_FrontColor = gl_Color;\n"
+            "}\n";
+        static const char *fragSrc =
+            "#version 120\n"
+            "uniform sampler2D baseTexture;\n"
+            "uniform sampler2DShadow shadowStatic[4];\n"
+            "uniform sampler2DShadow shadowDynamic[4];\n"
+            "uniform mat4 shadowStaticMatrix[4];\n"
+            "uniform mat4 shadowDynamicMatrix[4];\n"
+            "uniform vec4 shadowSplits;\n"
+            "uniform float shadowTexel;\n"
+            "uniform bool shadowEnabled;\n"
+            "varying vec3 eyePos;\n"
+            "varying vec3 eyeNormal;\n"
+            "varying vec4 worldPos;\n"
+            "float lookup(sampler2DShadow map, mat4 m)\n"
+            "{\n"
+            "    vec4 c = m * worldPos;\n"
+            "    if (c.x < 0.0 || c.x > 1.0 || c.y < 0.0 || c.y > 1.0 || c.z > 1.0) return 1.0;\n"
+            "    float d = shadowTexel * 0.5;\n"
+            "    return 0.25 * (shadow2D(map, c.xyz + vec3(-d, -d, 0.0)).r + shadow2D(map, c.xyz + vec3(d, -d, 0.0)).r +\n"
+            "                   shadow2D(map, c.xyz + vec3(-d, d, 0.0)).r + shadow2D(map, c.xyz + vec3(d, d, 0.0)).r);\n"
+            "}\n"
+            "float visibility()\n"
+            "{\n"
+            "    float depth = -eyePos.z;\n"
+            "    if (!shadowEnabled) return 1.0;\n"
+            "    if (depth < shadowSplits[0]) return min(lookup(shadowStatic[0], shadowStaticMatrix[0]), lookup(shadowDynamic[0], shadowDynamicMatrix[0]));\n"
+            "    if (depth < shadowSplits[1]) return min(lookup(shadowStatic[1], shadowStaticMatrix[1]), lookup(shadowDynamic[1], shadowDynamicMatrix[1]));\n"
+            "    if (depth < shadowSplits[2]) return min(lookup(shadowStatic[2], shadowStaticMatrix[2]), lookup(shadowDynamic[2], shadowDynamicMatrix[2]));\n"
+            "    if (depth < shadowSplits[3]) return min(lookup(shadowStatic[3], shadowStaticMatrix[3]), lookup(shadowDynamic[3], shadowDynamicMatrix[3]));\n"
+            "    return 1.0;\n"
+            "}\n"
+            "void main()\n"
+            "{\n"
+            "    vec3 n = normalize(gl_FrontFacing ? eyeNormal : -eyeNormal);\n"
+            "    vec4 lp = gl_LightSource[0].position;\n"
+            "    vec3 l = normalize(lp.w == 0.0 ? lp.xyz : lp.xyz - eyePos);\n"
+            "    vec3 h = normalize(l - normalize(eyePos));\n"
+            "    float ndl = max(dot(n, l), 0.0);\n"
+            "    float spec = ndl > 0.0 ? pow(max(dot(n, h), 0.0), max(gl_FrontMaterial.shininess, 1.0)) : 0.0;\n"
+            "    vec4 ambient = gl_FrontMaterial.emission + gl_LightModel.ambient * gl_FrontMaterial.ambient +\n"
+            "                   gl_FrontLightProduct[0].ambient;\n"
+            "    vec4 lit = gl_FrontLightProduct[0].diffuse * ndl + gl_FrontLightProduct[0].specular * spec;\n"
+            "    vec4 color = ambient + lit * visibility();\n"
+            "    color.a = gl_FrontMaterial.diffuse.a;\n"
+            "    gl_FragColor = color * texture2D(baseTexture, gl_TexCoord[0].st);\n"
+            "}\n";
+
+        _receiverProgram = new osg::Program;
+        _receiverProgram->addShader(new osg::Shader(osg::Shader::VERTEX, vertSrc));
+        _receiverProgram->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragSrc));
+
+        // Pushed around the normal traversal; values change during cull
+        _shadowState = new osg::StateSet;
+        _shadowState->setDataVariance(osg::Object::DYNAMIC);
+        _shadowState->addUniform(new osg::Uniform("baseTexture", 0));
+
+        _staticMatrices = new osg::Uniform(osg::Uniform::FLOAT_MAT4, "shadowStaticMatrix", 4);
+        _dynamicMatrices = new osg::Uniform(osg::Uniform::FLOAT_MAT4, "shadowDynamicMatrix", 4);
+        _splits = new osg::Uniform("shadowSplits", osg::Vec4());
+        _enabled = new osg::Uniform("shadowEnabled", false);
+        osg::ref_ptr<osg::Uniform> staticUnits = new osg::Uniform(osg::Uniform::SAMPLER_2D_SHADOW, "shadowStatic", 4);
+        osg::ref_ptr<osg::Uniform> dynamicUnits = new osg::Uniform(osg::Uniform::SAMPLER_2D_SHADOW, "shadowDynamic", 4);
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            // Unused cascades point at cascade 0; the splits never select them
+            const unsigned int c = i < _cascades.size() ? i : 0;
+            staticUnits->setElement(i, int(1 + c));
+            dynamicUnits->setElement(i, int(1 + _cascades.size() + c));
+        }
+        for (size_t i = 0; i < _cascades.size(); ++i)
+        {
+            // Shader-only units: no fixed-function enable, which would fail
+            // above GL_MAX_TEXTURE_UNITS
+            _shadowState->setTextureAttribute(1 + i, _cascades[i].staticMap.get());
+            _shadowState->setTextureAttribute(1 + _cascades.size() + i, _cascades[i].dynamicMap.get());
+        }
+        for (osg::Uniform *u : {_staticMatrices.get(), _dynamicMatrices.get(), _splits.get(), _enabled.get()})
+        {
+            u->setDataVariance(osg::Object::DYNAMIC);
+            _shadowState->addUniform(u);
+        }
+        _shadowState->addUniform(staticUnits.get());
+        _shadowState->addUniform(dynamicUnits.get());
+        _shadowState->addUniform(new osg::Uniform("shadowTexel", 1.0f / _settings.resolution));
+
+        std::cout << "CascadedShadowMap: " << _settings.cascades << " cascades, " << _settings.resolution << "^2, "
+                  << _settings.maxDistance << " m, dynamic casters at "
+                  << (_settings.dynamicRate > 0.0 ? std::to_string(_settings.dynamicRate) + " Hz" : std::string("frame rate"))
+                  << "\n";
+    }
+
+    // Light view matrix looking along `travel` from `eye`
+    static osg::Matrixd lightView(const osg::Vec3d &eye, const osg::Vec3d &travel)
+    {
+        osg::Vec3d up = std::fabs(travel.z()) < 0.9 ? osg::Vec3d(0, 0, 1) : osg::Vec3d(1, 0, 0);
+        return osg::Matrixd::lookAt(eye, eye + travel, up);
+    }
+
+    // World to [0,1] shadow texture space
+    static osg::Matrixd textureMatrix(const osg::Matrixd &view, const osg::Matrixd &projection)
+    {
+        return view * projection * osg::Matrixd::translate(1.0, 1.0, 1.0) * osg::Matrixd::scale(0.5, 0.5, 0.5);
+    }
+
+    // Fits a light-space ortho camera around the sphere (center, radius),
+    // snapped to whole texels; casters up to `pullBack` in front of the
+    // sphere are included
+    osg::Matrixd fitCamera(osg::Camera *camera, osg::Vec3d &center, double radius, double pullBack,
+                           const osg::Vec3d &travel) const
+    {
+        const osg::Matrixd rotation = lightView(osg::Vec3d(), travel);
+        const double texel = 2.0 * radius / _settings.resolution;
+        osg::Vec3d local = center * rotation;
+        local.x() = std::floor(local.x() / texel) * texel;
+        local.y() = std::floor(local.y() / texel) * texel;
+        center = local * osg::Matrixd::inverse(rotation);
+
+        const osg::Matrixd view = lightView(center - travel * (radius + pullBack), travel);
+        const osg::Matrixd projection =
+            osg::Matrixd::ortho(-radius, radius, -radius, radius, 0.0, pullBack + 2.0 * radius);
+        camera->setViewMatrix(view);
+        camera->setProjectionMatrix(projection);
+        return textureMatrix(view, projection);
+    }
+
+    void cullCasters(osgUtil::CullVisitor &cv)
+    {
+        osg::LightSource *source = _light.get();
+        osg::Light *light = source ? source->getLight() : nullptr;
+        const osg::StateAttribute::GLModeValue mode =
+            light && source->getStateSet() ? source->getStateSet()->getMode(GL_LIGHT0 + light->getLightNum())
+                                           : osg::StateAttribute::INHERIT;
+        const bool on = light && (mode == osg::StateAttribute::INHERIT || (mode & osg::StateAttribute::ON));
+        _enabled->set(on);
+        if (!on)
+        {
+            _staticValid = false;
+            return;
+        }
+
+        const osg::Camera *camera = cv.getCurrentCamera();
+        const osg::Matrixd viewInverse = camera->getInverseViewMatrix();
+        double fovy = 30.0, aspect = 1.0, zNear, zFar;
+        camera->getProjectionMatrixAsPerspective(fovy, aspect, zNear, zFar);
+        const double tanY = std::tan(osg::DegreesToRadians(fovy) * 0.5);
+        const double tanX = tanY * aspect;
+
+        // Direction the light travels, in world space
+        const osg::Vec4 lp = light->getPosition();
+        osg::Vec3d travel;
+        if (lp.w() == 0.0f)
+            travel = -osg::Vec3d(lp.x(), lp.y(), lp.z());
+        else
+            travel = viewInverse.getTrans() - osg::Vec3d(lp.x(), lp.y(), lp.z());
+        if (travel.normalize() == 0.0)
+            return;
+        if (travel * _staticTravel < 0.99999)
+        {
+            _staticTravel = travel;
+            _staticValid = false;
+        }
+
+        // Casters in front of a cascade: anything within the caster bounds
+        osg::BoundingSphere casterBound = _staticCasters->getBound();
+        casterBound.expandBy(_dynamicCasters->getBound());
+        const double pullBack = casterBound.valid() ? 2.0 * casterBound.radius() : _settings.maxDistance;
+
+        const double t = cv.getFrameStamp() ? cv.getFrameStamp()->getReferenceTime() : 0.0;
+        const bool dynamicDue = t >= _nextDynamic;
+        if (dynamicDue)
+            _nextDynamic = _settings.dynamicRate > 0.0 ? std::max(_nextDynamic + 1.0 / _settings.dynamicRate, t) : t;
+
+        const double n = _settings.nearDistance, f = _settings.maxDistance;
+        const unsigned int count = _cascades.size();
+        osg::Vec4 splits(0.0f, 0.0f, 0.0f, 0.0f);
+        double sliceNear = n;
+        bool staticRendered = false;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            const double k = double(i + 1) / count;
+            const double sliceFar = _settings.splitLambda * n * std::pow(f / n, k) +
+                                    (1.0 - _settings.splitLambda) * (n + (f - n) * k);
+            splits[i] = sliceFar;
+
+            // Bounding sphere of the slice: centred on the view axis where
+            // it is equidistant from the near and far corners
+            const double r2Near = sliceNear * sliceNear * (tanX * tanX + tanY * tanY);
+            const double r2Far = sliceFar * sliceFar * (tanX * tanX + tanY * tanY);
+            double z = 0.5 * (sliceNear + sliceFar) + 0.5 * (r2Far - r2Near) / (sliceFar - sliceNear);
+            z = std::min(z, sliceFar);
+            const double radius = std::sqrt((sliceFar - z) * (sliceFar - z) + r2Far);
+            osg::Vec3d center = osg::Vec3d(0.0, 0.0, -z) * viewInverse;
+
+            Cascade &c = _cascades[i];
+            if (!_staticValid || (center - c.staticCenter).length() + radius > c.staticRadius)
+            {
+                c.staticCenter = center;
+                c.staticRadius = radius * (1.0 + _settings.staticMargin);
+                _staticMatrices->setElement(i, osg::Matrixf(fitCamera(c.staticCamera.get(), c.staticCenter,
+                                                                      c.staticRadius, pullBack, travel)));
+                c.staticCamera->accept(cv);
+                staticRendered = true;
+            }
+            if (dynamicDue)
+            {
+                _dynamicMatrices->setElement(i, osg::Matrixf(fitCamera(c.dynamicCamera.get(), center, radius,
+                                                                       pullBack, travel)));
+                c.dynamicCamera->accept(cv);
+            }
+            sliceNear = sliceFar;
+        }
+        _staticValid = true;
+        if (staticRendered)
+            ++_staticRenders;
+        _splits->set(splits);
+    }
+
+    osg::observer_ptr<osg::LightSource> _light;
+    Settings _settings;
+    std::vector<Cascade> _cascades;
+    osg::ref_ptr<osg::Group> _staticCasters, _dynamicCasters;
+    osg::ref_ptr<osg::StateSet> _casterState, _shadowState;
+    osg::ref_ptr<osg::Program> _receiverProgram;
+    osg::ref_ptr<osg::Uniform> _staticMatrices, _dynamicMatrices, _splits, _enabled;
+
+    bool _staticValid = false;
+    osg::Vec3d _staticTravel;
+    double _nextDynamic = 0.0;
+    unsigned int _staticRenders = 0;
+};
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <osgViewer/ViewerEventHandlers>
+#include <osg/observer_ptr>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace osg {
 class Camera;
@@ -18,10 +22,10 @@ protected:
     virtual void drawUi() = 0;
 
 private:
-    void init();
-
     void setCameraCallbacks(osg::Camera* camera);
 
+    void addPanel(OsgImGuiHandler* panel);
+
     void newFrame(osg::RenderInfo& renderInfo);
 
     void render(osg::RenderInfo& renderInfo);
@@ -30,8 +34,30 @@ private:
     struct ImGuiNewFrameCallback;
     struct ImGuiRenderCallback;
 
+    // An OSG event recorded by handle() for the next newFrame()
+    struct InputEvent
+    {
+        enum Type { Key, Modifiers, Character, MousePos, MouseButton, MouseWheel };
+        Type type;
+        int code;
+        bool down;
+        float x, y;
+    };
+
     double time_;
-    bool mousePressed_[3];
-    float mouseWheel_;
     bool initialized_;
+
+    // All handlers share one ImGui context. The first one to see a camera
+    // owns its draw callbacks, the input queue and the capture flags, and
+    // draws the panels of the handlers that came after it
+    bool ownsCamera_;
+    std::vector<osg::observer_ptr<OsgImGuiHandler>> panels_;
+
+    // handle() runs on the event thread and ImGui on the draw thread:
+    // input is queued here and fed to ImGui in newFrame(), and the capture
+    // flags ImGui computes go back the other way
+    std::mutex mutex_;
+    std::vector<InputEvent> pendingInput_;
+    std::atomic<bool> wantCaptureMouse_;
+    std::atomic<bool> wantCaptureKeyboard_;
 };
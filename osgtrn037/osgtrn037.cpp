@@ -1,6 +1,7 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
 #include <osgViewer/Viewer>
 #include <osgViewer/config/SingleWindow>
 #include <osg/MatrixTransform>
@@ -20,6 +21,9 @@
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "CascadedShadows.hpp"
+#include "PropertySet.hpp"
+#include "CommandQueue.hpp"
 
 // ======================= ANSI Color Codes ===========================
 #define ANSI_RESET "\e[0;0m]"
@@ -43,16 +47,19 @@ public:
 };
 
 // ======================= Global Animation State ===========================
+// Written only in the update traversal, by the motion callbacks and by
+// commands posted from the panel; atomic so drawUi() can read it on the
+// draw thread.
 struct AnimationState
 {
-    bool running = false;
-    bool logging = false;
-    float t = 0.0f;
-    float speed = 0.25f;
-    bool isFighter = true;
+    std::atomic<bool> running{false};
+    std::atomic<bool> logging{false};
+    std::atomic<float> t{0.0f};
+    std::atomic<float> speed{0.25f};
+    std::atomic<bool> isFighter{true};
 } gAnim;
 
-float gTailOffset = -14.0f;
+std::atomic<float> gTailOffset{-14.0f};
 const osg::Vec3 WORLD_UP(0, 0, -1);
 
 // ======================= Basis Adjustments ===========================
@@ -137,6 +144,7 @@ public:
     {
         _verts = new osg::Vec3Array;
         _geom = new osg::Geometry;
+        _geom->setDataVariance(osg::Object::DYNAMIC);
         _draw = new osg::DrawArrays(GL_LINE_STRIP, 0, 0);
         _geom->setVertexArray(_verts.get());
         _geom->addPrimitiveSet(_draw.get());
@@ -195,14 +203,16 @@ public:
     {
         if (gAnim.running)
         {
-            gAnim.t += gAnim.speed * 0.01f;
-            if (gAnim.t >= 1.0f) { gAnim.t = 1.0f; gAnim.running = false; }
+            float next = gAnim.t + gAnim.speed * 0.01f;
+            if (next >= 1.0f) { next = 1.0f; gAnim.running = false; }
+            gAnim.t = next;
         }
+        const float t = gAnim.t;
         float dt = 0.02f;
-        float t0 = std::max(0.0f, gAnim.t - dt);
-        float t2 = std::min(1.0f, gAnim.t + dt);
+        float t0 = std::max(0.0f, t - dt);
+        float t2 = std::min(1.0f, t + dt);
         osg::Vec3 p0 = aircraftTrajectory(t0);
-        osg::Vec3 p1 = aircraftTrajectory(gAnim.t);
+        osg::Vec3 p1 = aircraftTrajectory(t);
         osg::Vec3 p2 = aircraftTrajectory(t2);
         osg::Vec3 fwd = p2 - p1; if (fwd.length2() < 1e-8f) fwd = p1 - p0; fwd.normalize();
         osg::Quat orient = orientationFromTangent(fwd, WORLD_UP, gAnim.isFighter);
@@ -229,11 +239,12 @@ public:
         : mt(m), _trail(trail) {}
     void operator()(osg::Node*, osg::NodeVisitor* nv) override
     {
+        const float t = gAnim.t;
         float dt = 0.02f;
-        float t0 = std::max(0.0f, gAnim.t - dt);
-        float t2 = std::min(1.0f, gAnim.t + dt);
+        float t0 = std::max(0.0f, t - dt);
+        float t2 = std::min(1.0f, t + dt);
         osg::Vec3 p0 = missileTrajectory(t0);
-        osg::Vec3 p1 = missileTrajectory(gAnim.t);
+        osg::Vec3 p1 = missileTrajectory(t);
         osg::Vec3 p2 = missileTrajectory(t2);
         osg::Vec3 fwd = p2 - p1; if (fwd.length2() < 1e-8f) fwd = p1 - p0; fwd.normalize();
         osg::Quat orient = orientationFromTangent(fwd, WORLD_UP, !gAnim.isFighter);
@@ -252,109 +263,157 @@ private:
 };
 
 // ======================= ImGui Controls ===========================
+// Runs on the draw thread: every action is posted to the CommandQueue and
+// happens in the next update traversal.
 class ImGuiControl : public OsgImGuiHandler
 {
 public:
-    ImGuiControl(Trail* t1, Trail* t2) : _trail1(t1), _trail2(t2) {}
+    ImGuiControl(CommandQueue* commands, Trail* t1, Trail* t2) : _commands(commands), _trail1(t1), _trail2(t2) {}
 protected:
     void drawUi() override
     {
         ImGui::Begin("Motion Controller");
         if (ImGui::Button(gAnim.running ? "Stop" : "Start"))
-            gAnim.running = !gAnim.running;
+            _commands->post([]() { gAnim.running = !gAnim.running; });
         ImGui::SameLine();
         if (ImGui::Button("Reset"))
         {
-            gAnim.t = 0.0f; gAnim.running = false;
-            if (_trail1.valid()) _trail1->clear();
-            if (_trail2.valid()) _trail2->clear();
-            std::cout << ANSI_CYAN << "=== Reset motion & trails ===" << ANSI_RESET << std::endl;
+            _commands->post([this]()
+            {
+                gAnim.t = 0.0f; gAnim.running = false;
+                if (_trail1.valid()) _trail1->clear();
+                if (_trail2.valid()) _trail2->clear();
+                std::cout << ANSI_CYAN << "=== Reset motion & trails ===" << ANSI_RESET << std::endl;
+            });
         }
-        ImGui::SliderFloat("Speed", &gAnim.speed, 0.05f, 1.0f, "%.2f");
-        ImGui::SliderFloat("t (timeline)", &gAnim.t, 0.0f, 1.0f, "%.3f");
-        ImGui::SliderFloat("Tail Offset", &gTailOffset, -60.0f, 0.0f, "%.1f");
+        float speed = gAnim.speed;
+        if (ImGui::SliderFloat("Speed", &speed, 0.05f, 1.0f, "%.2f"))
+            _commands->post([speed]() { gAnim.speed = speed; });
+        float t = gAnim.t;
+        if (ImGui::SliderFloat("t (timeline)", &t, 0.0f, 1.0f, "%.3f"))
+            _commands->post([t]() { gAnim.t = t; });
+        float tailOffset = gTailOffset;
+        if (ImGui::SliderFloat("Tail Offset", &tailOffset, -60.0f, 0.0f, "%.1f"))
+            _commands->post([tailOffset]() { gTailOffset = tailOffset; });
         ImGui::End();
     }
 private:
+    osg::ref_ptr<CommandQueue> _commands;
     osg::observer_ptr<Trail> _trail1;
     osg::observer_ptr<Trail> _trail2;
 };
 
 // ======================= Light Control (inverted Z) ===========================
+// The panel only edits properties; the light and its marker are written
+// by the PropertySet during the next update traversal, and only for the
+// values that actually changed. The shadow map reads the light during
+// cull, after the update has applied it.
 class LightControl : public OsgImGuiHandler
 {
 public:
     LightControl(osg::LightSource* lightSrc, osg::ShapeDrawable* marker)
-        : _lightSrc(lightSrc), _marker(marker)
+        : _properties(new PropertySet)
     {
-        _pos = osg::Vec3(0.0f, 50.0f, -80.0f);
-        _dir = osg::Vec3(0.0f, 0.0f, 1.0f); // upward (sky is -Z)
-        _ambient = osg::Vec4(0.2f, 0.2f, 0.2f, 1.0f);
-        _diffuse = osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
-        _specular = osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
-        _directional = true;
-        _enabled = true;
+        // The set is owned by the light source, so applying through the raw
+        // pointer is safe; the others are held by the closures
+        osg::ref_ptr<osg::Light> light = lightSrc->getLight();
+        osg::ref_ptr<osg::ShapeDrawable> bulb = marker;
+        // DYNAMIC so the light edits wait for the last draw (see PropertySet.hpp)
+        bulb->setDataVariance(osg::Object::DYNAMIC);
+        lightSrc->getOrCreateStateSet()->setDataVariance(osg::Object::DYNAMIC);
+        lightSrc->addUpdateCallback(_properties.get());
+
+        Placement placement;
+        placement.directional = true;
+        placement.pos = osg::Vec3(0.0f, 50.0f, -80.0f);
+        placement.dir = osg::Vec3(0.4f, 0.3f, -0.6f); // towards the sun, above the horizon (sky is -Z)
+        _placement = _properties->add<Placement>(placement, [light, bulb](const Placement& p)
+        {
+            if (p.directional)
+                light->setPosition(osg::Vec4(p.dir, 0.0f));  // w=0 => directional
+            else
+                light->setPosition(osg::Vec4(p.pos, 1.0f));  // w=1 => positional
+
+            if (p.directional)
+                bulb->setShape(new osg::Sphere(osg::Vec3(0, 0, 0), 0.0f)); // hide marker
+            else
+                bulb->setShape(new osg::Sphere(p.pos, 2.5f));
+        });
+
+        _enabled = _properties->add<bool>(true, [lightSrc](const bool& on)
+        {
+            lightSrc->setLocalStateSetModes(on ? osg::StateAttribute::ON : osg::StateAttribute::OFF);
+        });
+        _ambient = _properties->add<osg::Vec4>(osg::Vec4(0.2f, 0.2f, 0.2f, 1.0f),
+                                               [light](const osg::Vec4& c) { light->setAmbient(c); });
+        _diffuse = _properties->add<osg::Vec4>(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f),
+                                               [light](const osg::Vec4& c) { light->setDiffuse(c); });
+        _specular = _properties->add<osg::Vec4>(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f),
+                                                [light](const osg::Vec4& c) { light->setSpecular(c); });
     }
 
 protected:
     void drawUi() override
     {
         ImGui::Begin("Light Controls");
-        ImGui::Checkbox("Enable Light", &_enabled);
-        ImGui::Checkbox("Directional (Sunlight)", &_directional);
-        ImGui::SliderFloat3("Position (XYZ)", _pos.ptr(), -200.0f, 200.0f, "%.1f");
-        ImGui::SliderFloat3("Direction", _dir.ptr(), -1.0f, 1.0f, "%.2f");
-        ImGui::ColorEdit3("Ambient", _ambient.ptr());
-        ImGui::ColorEdit3("Diffuse", _diffuse.ptr());
-        ImGui::ColorEdit3("Specular", _specular.ptr());
-
-        osg::Light* light = _lightSrc->getLight();
-
-        if (_directional)
-            light->setPosition(osg::Vec4(_dir, 0.0f));  // w=0 => directional
-        else
-            light->setPosition(osg::Vec4(_pos, 1.0f));  // w=1 => positional
-
-        light->setAmbient(_ambient);
-        light->setDiffuse(_diffuse);
-        light->setSpecular(_specular);
-
-        if (_enabled)
-            _lightSrc->setLocalStateSetModes(osg::StateAttribute::ON);
-        else
-            _lightSrc->setLocalStateSetModes(osg::StateAttribute::OFF);
-
-        // ✅ fixed validity check for observer_ptr
-        if (_marker.valid())
-        {
-            if (_directional)
-                _marker->setShape(new osg::Sphere(osg::Vec3(0, 0, 0), 0.0f)); // hide marker
-            else
-                _marker->setShape(new osg::Sphere(_pos, 2.5f));
-        }
-
+        if (ImGui::Checkbox("Enable Light", &_enabled->edit()))
+            _enabled->changed();
+
+        Placement& p = _placement->edit();
+        bool moved = ImGui::Checkbox("Directional (Sunlight)", &p.directional);
+        moved |= ImGui::SliderFloat3("Position (XYZ)", p.pos.ptr(), -200.0f, 200.0f, "%.1f");
+        moved |= ImGui::SliderFloat3("Direction", p.dir.ptr(), -1.0f, 1.0f, "%.2f");
+        if (moved)
+            _placement->changed();
+
+        if (ImGui::ColorEdit3("Ambient", _ambient->edit().ptr()))
+            _ambient->changed();
+        if (ImGui::ColorEdit3("Diffuse", _diffuse->edit().ptr()))
+            _diffuse->changed();
+        if (ImGui::ColorEdit3("Specular", _specular->edit().ptr()))
+            _specular->changed();
         ImGui::End();
     }
 
 private:
-    osg::observer_ptr<osg::LightSource> _lightSrc;
-    osg::observer_ptr<osg::ShapeDrawable> _marker;
-    osg::Vec3 _pos, _dir;
-    osg::Vec4 _ambient, _diffuse, _specular;
-    bool _directional, _enabled;
+    // Light position and marker both derive from these together
+    struct Placement
+    {
+        bool directional;
+        osg::Vec3 pos, dir;
+    };
+
+    osg::ref_ptr<PropertySet> _properties;
+    PropertySet::Property<Placement>* _placement;
+    PropertySet::Property<bool>* _enabled;
+    PropertySet::Property<osg::Vec4>* _ambient;
+    PropertySet::Property<osg::Vec4>* _diffuse;
+    PropertySet::Property<osg::Vec4>* _specular;
 };
 
 // ======================= Main ===========================
-int main(int, char**)
+int main(int argc, char** argv)
 {
     const std::string dataPath = "/home/murate/Documents/SwTrn/OsgTrn/OpenSceneGraph-Data/";
+
+    // --shadow-cascades <1..4> --shadow-res <texels> --shadow-rate <Hz, 0 = every frame> --shadow-distance <m>
+    osg::ArgumentParser arguments(&argc, argv);
+    CascadedShadowMap::Settings shadowSettings;
+    arguments.read("--shadow-cascades", shadowSettings.cascades);
+    arguments.read("--shadow-res", shadowSettings.resolution);
+    arguments.read("--shadow-rate", shadowSettings.dynamicRate);
+    arguments.read("--shadow-distance", shadowSettings.maxDistance);
     osg::ref_ptr<osg::Group> root = new osg::Group();
     root->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::ON);
 
+    // UI actions, run at the start of each update traversal
+    osg::ref_ptr<CommandQueue> commands = new CommandQueue;
+    root->addUpdateCallback(commands);
+
     // --- Light setup (Z=-1 up world) ---
     osg::ref_ptr<osg::Light> light = new osg::Light;
     light->setLightNum(0);
-    light->setPosition(osg::Vec4(0.0f, 0.0f, 1.0f, 0.0f)); // directional upward
+    light->setPosition(osg::Vec4(0.4f, 0.3f, -0.6f, 0.0f)); // directional, from above
     light->setAmbient(osg::Vec4(0.2f, 0.2f, 0.2f, 1.0f));
     light->setDiffuse(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f));
     light->setSpecular(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f));
@@ -371,6 +430,16 @@ int main(int, char**)
     lightMarker->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
     root->addChild(lightMarker);
 
+    // --- Shadows: terrain is static, the aircraft are dynamic casters ---
+    osg::ref_ptr<CascadedShadowMap> shadows = new CascadedShadowMap(lightSrc.get(), shadowSettings);
+    root->addChild(shadows);
+
+    osg::ref_ptr<osg::MatrixTransform> terrain = new osg::MatrixTransform;
+    terrain->addChild(osgDB::readRefNodeFile(dataPath + "lz.osg"));
+    terrain->setMatrix(osg::Matrix::rotate(osg::PI, osg::X_AXIS) * osg::Matrix::translate(0.0, 0.0, 200.0)); // Z-up model, 200 below
+    shadows->addStaticCaster(terrain);
+    shadows->addReceiver(terrain);
+
     // --- Axes & Models ---
     osg::ref_ptr<osg::Node> refAxes = osgDB::readRefNodeFile(dataPath + "axes.osgt");
     osg::ref_ptr<osg::MatrixTransform> refAxesXForm = new osg::MatrixTransform;
@@ -386,7 +455,7 @@ int main(int, char**)
     aircraft->addChild(f14);
     aircraft->addChild(createAxes(15.0f));
     // aircraft->addUpdateCallback(new F14MotionCallback(aircraft, trailF14.get(), -24.0f));
-    root->addChild(aircraft);
+    shadows->addDynamicCaster(aircraft);
 
     osg::ref_ptr<Trail> trailMissile = new Trail(1500, 0.15f);
     osg::ref_ptr<osg::Node> missileModel = osgDB::readRefNodeFile(dataPath + "AIM-9L.ac");
@@ -394,7 +463,7 @@ int main(int, char**)
     missile->addChild(missileModel);
     missile->addChild(createAxes(8.0f));
     // missile->addUpdateCallback(new MissileMotionCallback(missile.get(), trailMissile.get()));
-    root->addChild(missile);
+    shadows->addDynamicCaster(missile);
     root->addChild(trailMissile->geode());
 
     // --- Viewer ---
@@ -402,7 +471,7 @@ int main(int, char**)
     viewer.apply(new osgViewer::SingleWindow(100, 100, 1000, 700));
     viewer.setSceneData(root);
     viewer.setRealizeOperation(new ImGuiInitOperation);
-    viewer.addEventHandler(new ImGuiControl(trailF14.get(), trailMissile.get()));
+    viewer.addEventHandler(new ImGuiControl(commands.get(), trailF14.get(), trailMissile.get()));
     viewer.addEventHandler(new LightControl(lightSrc.get(), lightSphere.get()));
 
     return viewer.run();
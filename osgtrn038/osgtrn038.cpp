@@ -1,6 +1,7 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
 #include <osgViewer/Viewer>
 #include <osgViewer/config/SingleWindow>
 #include <osg/MatrixTransform>
@@ -19,6 +20,8 @@
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "PropertySet.hpp"
+#include "CommandQueue.hpp"
 
 // ======================= ANSI Color Codes ===========================
 #define ANSI_RESET "\e[0;0m]"
@@ -39,16 +42,19 @@ public:
 };
 
 // ======================= Global Animation State ===========================
+// Written only in the update traversal, by commands posted from the
+// panel; atomic so drawUi() can read it on the
+// draw thread.
 struct AnimationState
 {
-    bool running = false;
-    bool logging = false;
-    float t = 0.0f;
-    float speed = 0.25f;
-    bool isFighter = true;
+    std::atomic<bool> running{false};
+    std::atomic<bool> logging{false};
+    std::atomic<float> t{0.0f};
+    std::atomic<float> speed{0.25f};
+    std::atomic<bool> isFighter{true};
 } gAnim;
 
-float gTailOffset = -14.0f;
+std::atomic<float> gTailOffset{-14.0f};
 const osg::Vec3 WORLD_UP(0, 0, -1);
 
 // ======================= Basis Adjustments ===========================
@@ -96,96 +102,134 @@ osg::ref_ptr<osg::Geode> createAxes(float len = 10.0f)
 }
 
 // ======================= ImGui Motion Control ===========================
+// Runs on the draw thread: every action is posted to the CommandQueue and
+// happens in the next update traversal.
 class ImGuiControl : public OsgImGuiHandler
 {
+public:
+    ImGuiControl(CommandQueue* commands) : _commands(commands) {}
 protected:
     void drawUi() override
     {
         ImGui::Begin("Motion Controller");
         if (ImGui::Button(gAnim.running ? "Stop" : "Start"))
-            gAnim.running = !gAnim.running;
+            _commands->post([]() { gAnim.running = !gAnim.running; });
         ImGui::SameLine();
         if (ImGui::Button("Reset"))
         {
-            gAnim.t = 0.0f; gAnim.running = false;
-            std::cout << ANSI_CYAN << "=== Reset motion & trails ===" << ANSI_RESET << std::endl;
+            _commands->post([]()
+            {
+                gAnim.t = 0.0f; gAnim.running = false;
+                std::cout << ANSI_CYAN << "=== Reset motion & trails ===" << ANSI_RESET << std::endl;
+            });
         }
-        ImGui::SliderFloat("Speed", &gAnim.speed, 0.05f, 1.0f, "%.2f");
-        ImGui::SliderFloat("t (timeline)", &gAnim.t, 0.0f, 1.0f, "%.3f");
+        float speed = gAnim.speed;
+        if (ImGui::SliderFloat("Speed", &speed, 0.05f, 1.0f, "%.2f"))
+            _commands->post([speed]() { gAnim.speed = speed; });
+        float t = gAnim.t;
+        if (ImGui::SliderFloat("t (timeline)", &t, 0.0f, 1.0f, "%.3f"))
+            _commands->post([t]() { gAnim.t = t; });
         ImGui::End();
     }
+private:
+    osg::ref_ptr<CommandQueue> _commands;
 };
 
 // ======================= Light Control ===========================
+// The panel only edits properties; the light and its symbol are written
+// by the PropertySet during the next update traversal, and only for the
+// values that actually changed.
 class LightControl : public OsgImGuiHandler
 {
 public:
     LightControl(osg::LightSource* lightSrc, osg::MatrixTransform* symbolXform)
-        : _lightSrc(lightSrc), _symbolXform(symbolXform)
+        : _properties(new PropertySet)
     {
-        _pos = osg::Vec3(0.0f, 50.0f, -80.0f);
-        _dir = osg::Vec3(0.0f, 0.0f, 1.0f); // upward (sky is -Z)
-        _ambient = osg::Vec4(0.2f, 0.2f, 0.2f, 1.0f);
-        _diffuse = osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
-        _specular = osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
-        _directional = true;
-        _enabled = true;
+        // The set is owned by the light source, so applying through the raw
+        // pointer is safe; the others are held by the closures
+        osg::ref_ptr<osg::Light> light = lightSrc->getLight();
+        osg::ref_ptr<osg::MatrixTransform> symbol = symbolXform;
+        // DYNAMIC so the light edits wait for the last draw (see PropertySet.hpp)
+        if (symbol.valid())
+            symbol->getOrCreateStateSet()->setDataVariance(osg::Object::DYNAMIC);
+        lightSrc->getOrCreateStateSet()->setDataVariance(osg::Object::DYNAMIC);
+        lightSrc->addUpdateCallback(_properties.get());
+
+        Placement placement;
+        placement.directional = true;
+        placement.pos = osg::Vec3(0.0f, 50.0f, -80.0f);
+        placement.dir = osg::Vec3(0.0f, 0.0f, 1.0f); // upward (sky is -Z)
+        _placement = _properties->add<Placement>(placement, [light, symbol](const Placement& p)
+        {
+            if (p.directional)
+                light->setPosition(osg::Vec4(p.dir, 0.0f));
+            else
+                light->setPosition(osg::Vec4(p.pos, 1.0f));
+
+            if (symbol.valid())
+            {
+                osg::Matrix M;
+                if (p.directional)
+                {
+                    osg::Vec3 dir = p.dir; dir.normalize();
+                    osg::Matrix R = osg::Matrix::rotate(osg::Vec3(0, 0, -1), dir);
+                    M = R * osg::Matrix::translate(p.pos);
+                }
+                else
+                    M = osg::Matrix::translate(p.pos);
+                symbol->setMatrix(M);
+            }
+        });
+
+        _enabled = _properties->add<bool>(true, [lightSrc](const bool& on)
+        {
+            lightSrc->setLocalStateSetModes(on ? osg::StateAttribute::ON : osg::StateAttribute::OFF);
+        });
+        _ambient = _properties->add<osg::Vec4>(osg::Vec4(0.2f, 0.2f, 0.2f, 1.0f),
+                                               [light](const osg::Vec4& c) { light->setAmbient(c); });
+        _diffuse = _properties->add<osg::Vec4>(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f),
+                                               [light](const osg::Vec4& c) { light->setDiffuse(c); });
+        _specular = _properties->add<osg::Vec4>(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f),
+                                                [light](const osg::Vec4& c) { light->setSpecular(c); });
     }
 
 protected:
     void drawUi() override
     {
         ImGui::Begin("Light Controls");
-        ImGui::Checkbox("Enable Light", &_enabled);
-        ImGui::Checkbox("Directional (Sunlight)", &_directional);
-        ImGui::SliderFloat3("Position (XYZ)", _pos.ptr(), -200.0f, 200.0f, "%.1f");
-        ImGui::SliderFloat3("Direction", _dir.ptr(), -1.0f, 1.0f, "%.2f");
-        ImGui::ColorEdit3("Ambient", _ambient.ptr());
-        ImGui::ColorEdit3("Diffuse", _diffuse.ptr());
-        ImGui::ColorEdit3("Specular", _specular.ptr());
-
-        osg::Light* light = _lightSrc->getLight();
-        if (_directional)
-            light->setPosition(osg::Vec4(_dir, 0.0f)); // directional
-        else
-            light->setPosition(osg::Vec4(_pos, 1.0f)); // positional
-
-        light->setAmbient(_ambient);
-        light->setDiffuse(_diffuse);
-        light->setSpecular(_specular);
-
-        if (_enabled)
-            _lightSrc->setLocalStateSetModes(osg::StateAttribute::ON);
-        else
-            _lightSrc->setLocalStateSetModes(osg::StateAttribute::OFF);
-
-        // === Update the light symbol transform ===
-        if (_symbolXform.valid())
-        {
-            osg::Matrix M;
-            if (_directional)
-            {
-                osg::Vec3 dir = _dir;
-                dir.normalize();
-                osg::Matrix R = osg::Matrix::rotate(osg::Vec3(0, 0, -1), dir);
-                M = R * osg::Matrix::translate(_pos);
-            }
-            else
-            {
-                M = osg::Matrix::translate(_pos);
-            }
-            _symbolXform->setMatrix(M);
-        }
+        if (ImGui::Checkbox("Enable Light", &_enabled->edit()))
+            _enabled->changed();
+
+        Placement& p = _placement->edit();
+        bool moved = ImGui::Checkbox("Directional (Sunlight)", &p.directional);
+        moved |= ImGui::SliderFloat3("Position (XYZ)", p.pos.ptr(), -200.0f, 200.0f, "%.1f");
+        moved |= ImGui::SliderFloat3("Direction", p.dir.ptr(), -1.0f, 1.0f, "%.2f");
+        if (moved)
+            _placement->changed();
 
+        if (ImGui::ColorEdit3("Ambient", _ambient->edit().ptr()))
+            _ambient->changed();
+        if (ImGui::ColorEdit3("Diffuse", _diffuse->edit().ptr()))
+            _diffuse->changed();
+        if (ImGui::ColorEdit3("Specular", _specular->edit().ptr()))
+            _specular->changed();
         ImGui::End();
     }
 
 private:
-    osg::observer_ptr<osg::LightSource> _lightSrc;
-    osg::observer_ptr<osg::MatrixTransform> _symbolXform;
-    osg::Vec3 _pos, _dir;
-    osg::Vec4 _ambient, _diffuse, _specular;
-    bool _directional, _enabled;
+    // Light position and symbol both derive from these together
+    struct Placement
+    {
+        bool directional;
+        osg::Vec3 pos, dir;
+    };
+
+    osg::ref_ptr<PropertySet> _properties;
+    PropertySet::Property<Placement>* _placement;
+    PropertySet::Property<bool>* _enabled;
+    PropertySet::Property<osg::Vec4>* _ambient;
+    PropertySet::Property<osg::Vec4>* _diffuse;
+    PropertySet::Property<osg::Vec4>* _specular;
 };
 
 // ======================= Main ===========================
@@ -194,6 +238,10 @@ int main(int, char**)
     osg::ref_ptr<osg::Group> root = new osg::Group();
     root->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::ON);
 
+    // UI actions, run at the start of each update traversal
+    osg::ref_ptr<CommandQueue> commands = new CommandQueue;
+    root->addUpdateCallback(commands);
+
     // --- Light setup ---
     osg::ref_ptr<osg::Light> light = new osg::Light;
     light->setLightNum(0);
@@ -235,7 +283,7 @@ int main(int, char**)
     viewer.apply(new osgViewer::SingleWindow(100, 100, 1000, 700));
     viewer.setSceneData(root);
     viewer.setRealizeOperation(new ImGuiInitOperation);
-    viewer.addEventHandler(new ImGuiControl());
+    viewer.addEventHandler(new ImGuiControl(commands.get()));
     viewer.addEventHandler(new LightControl(lightSrc.get(), lightSymbolXform.get()));
 
     return viewer.run();
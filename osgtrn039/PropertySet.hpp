@@ -0,0 +1,104 @@
+#pragma once
+#include <osg/NodeCallback>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//
+// PropertySet
+// -----------
+// Scene parameters edited from ImGui panels.
+//
+// drawUi() runs on the draw thread, so a panel must not write the scene
+// graph. Instead its widgets bind to a property's edit() value, and the
+// panel calls changed() when ImGui reports an edit. The set is installed
+// as an update callback. At the next update traversal it applies every
+// property changed since the last one, once and in the order they were
+// added, under one lock.
+//
+// Untouched properties cost nothing per frame, several edits in one frame
+// collapse into one apply, and the scene graph is only written during
+// update, which is safe under any threading model. Every property is
+// applied once at the first update, so the scene starts in the state the
+// widgets show.
+//
+// Writing in update is only half of it: with DrawThreadPerContext the next
+// update may overlap the previous draw, and only DYNAMIC drawables and
+// StateSets hold it back. Mark DYNAMIC whatever an apply function writes.
+// State that is not a drawable or StateSet itself, such as an osg::Light
+// applied at the start of the draw, is covered by a DYNAMIC drawable or
+// StateSet drawn after it.
+//
+class PropertySet : public osg::NodeCallback
+{
+    struct Entry
+    {
+        virtual ~Entry() {}
+        virtual void apply() = 0;
+        bool dirty = true;
+    };
+
+public:
+    template <class T>
+    class Property : public Entry
+    {
+    public:
+        Property(PropertySet *set, const T &initial, std::function<void(const T &)> apply)
+            : _set(set), _edit(initial), _pending(initial), _apply(std::move(apply)) {}
+
+        // The value widgets edit; UI thread only
+        T &edit() { return _edit; }
+
+        // Publishes edit() to be applied at the next update
+        void changed()
+        {
+            std::lock_guard<std::mutex> lock(_set->_mutex);
+            _pending = _edit;
+            dirty = true;
+            _set->_dirty = true;
+        }
+
+    private:
+        void apply() override { _apply(_pending); }
+
+        PropertySet *_set;
+        T _edit;
+        T _pending;
+        std::function<void(const T &)> _apply;
+    };
+
+    // `apply` runs in the update traversal with the latest published value
+    template <class T>
+    Property<T> *add(const T &initial, std::function<void(const T &)> apply)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.emplace_back(new Property<T>(this, initial, std::move(apply)));
+        _dirty = true;
+        return static_cast<Property<T> *>(_entries.back().get());
+    }
+
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_dirty)
+            {
+                for (const std::unique_ptr<Entry> &e : _entries)
+                {
+                    if (e->dirty)
+                        e->apply();
+                    e->dirty = false;
+                }
+                _dirty = false;
+            }
+        }
+        traverse(node, nv);
+    }
+
+private:
+    std::mutex _mutex;
+    bool _dirty = false;
+    std::vector<std::unique_ptr<Entry>> _entries;
+};
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
 #include <osgViewer/Viewer>
 #include <osgViewer/config/SingleWindow>
 #include <osg/MatrixTransform>
@@ -15,10 +16,15 @@
 #include <osg/ShapeDrawable>
 #include <osg/Light>
 #include <osg/LightSource>
+#include <osg/Depth>
+#include <osg/Program>
+#include <osg/Uniform>
 
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "PropertySet.hpp"
+#include "CommandQueue.hpp"
 
 #define ANSI_RESET "\e[0;0m]"
 #define ANSI_CYAN "\e[0;36m"
@@ -36,11 +42,14 @@ public:
     }
 };
 
+// Written only in the update traversal, by commands posted from the
+// panel; atomic so drawUi() can read it on the
+// draw thread.
 struct AnimationState
 {
-    bool running = false;
-    float t = 0.0f;
-    float speed = 0.25f;
+    std::atomic<bool> running{false};
+    std::atomic<float> t{0.0f};
+    std::atomic<float> speed{0.25f};
 } gAnim;
 
 const osg::Vec3 WORLD_UP(0, 0, -1);
@@ -66,135 +75,210 @@ osg::ref_ptr<osg::Geode> createAxes(float len = 10.0f)
 }
 
 // -------------------- ImGui Motion Control --------------------
+// Runs on the draw thread: every action is posted to the CommandQueue and
+// happens in the next update traversal.
 class ImGuiControl : public OsgImGuiHandler
 {
+public:
+    ImGuiControl(CommandQueue* commands) : _commands(commands) {}
 protected:
     void drawUi() override
     {
         ImGui::Begin("Motion Controller");
         if (ImGui::Button(gAnim.running ? "Stop" : "Start"))
-            gAnim.running = !gAnim.running;
-        ImGui::SliderFloat("Speed", &gAnim.speed, 0.05f, 1.0f, "%.2f");
+            _commands->post([]() { gAnim.running = !gAnim.running; });
+        float speed = gAnim.speed;
+        if (ImGui::SliderFloat("Speed", &speed, 0.05f, 1.0f, "%.2f"))
+            _commands->post([speed]() { gAnim.speed = speed; });
         ImGui::End();
     }
+private:
+    osg::ref_ptr<CommandQueue> _commands;
 };
 
 // -------------------- Light Control --------------------
+// The panel only edits properties; the light, its symbol and the sky are
+// written by the PropertySet during the next update traversal, and only
+// for the values that actually changed.
 class LightControl : public OsgImGuiHandler
 {
 public:
-    LightControl(osg::LightSource* lightSrc, osg::MatrixTransform* symbolXform)
-        : _lightSrc(lightSrc), _symbolXform(symbolXform)
+    LightControl(osg::LightSource* lightSrc, osg::MatrixTransform* symbolXform, osg::Uniform* sunDirection)
+        : _properties(new PropertySet)
     {
-        _pos = osg::Vec3(0.0f, 50.0f, -80.0f);
-        _dir = osg::Vec3(0.0f, 0.0f, 1.0f);
-        _ambient = osg::Vec4(0.2f, 0.2f, 0.2f, 1.0f);
-        _diffuse = osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
-        _specular = osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
-        _directional = true;
-        _enabled = true;
+        // The set is owned by the light source, so applying through the raw
+        // pointer is safe; the others are held by the closures
+        osg::ref_ptr<osg::Light> light = lightSrc->getLight();
+        osg::ref_ptr<osg::MatrixTransform> symbol = symbolXform;
+        osg::ref_ptr<osg::Uniform> sun = sunDirection;
+        // DYNAMIC so the light edits wait for the last draw (see PropertySet.hpp)
+        if (symbol.valid())
+            symbol->getOrCreateStateSet()->setDataVariance(osg::Object::DYNAMIC);
+        lightSrc->getOrCreateStateSet()->setDataVariance(osg::Object::DYNAMIC);
+        lightSrc->addUpdateCallback(_properties.get());
+
+        Placement placement;
+        placement.directional = true;
+        placement.pos = osg::Vec3(0.0f, 50.0f, -80.0f);
+        placement.dir = osg::Vec3(0.4f, 0.3f, -0.6f); // towards the sun, above the horizon (-Z up)
+        _placement = _properties->add<Placement>(placement, [light, symbol, sun](const Placement& p)
+        {
+            if (p.directional)
+                light->setPosition(osg::Vec4(p.dir, 0.0f));
+            else
+                light->setPosition(osg::Vec4(p.pos, 1.0f));
+
+            // The sky follows the light direction, or the direction towards a
+            // positional light from the origin
+            if (sun.valid())
+            {
+                osg::Vec3 towards = p.directional ? p.dir : p.pos;
+                if (towards.normalize() > 0.0f)
+                    sun->set(towards);
+            }
+
+            if (symbol.valid())
+            {
+                osg::Matrix M;
+                if (p.directional)
+                {
+                    osg::Vec3 dir = p.dir; dir.normalize();
+                    osg::Matrix R = osg::Matrix::rotate(osg::Vec3(0, 0, -1), dir);
+                    M = R * osg::Matrix::translate(p.pos);
+                }
+                else
+                    M = osg::Matrix::translate(p.pos);
+                symbol->setMatrix(M);
+            }
+        });
+
+        _enabled = _properties->add<bool>(true, [lightSrc](const bool& on)
+        {
+            lightSrc->setLocalStateSetModes(on ? osg::StateAttribute::ON : osg::StateAttribute::OFF);
+        });
+        _ambient = _properties->add<osg::Vec4>(osg::Vec4(0.2f, 0.2f, 0.2f, 1.0f),
+                                               [light](const osg::Vec4& c) { light->setAmbient(c); });
+        _diffuse = _properties->add<osg::Vec4>(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f),
+                                               [light](const osg::Vec4& c) { light->setDiffuse(c); });
+        _specular = _properties->add<osg::Vec4>(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f),
+                                                [light](const osg::Vec4& c) { light->setSpecular(c); });
     }
 
 protected:
     void drawUi() override
     {
         ImGui::Begin("Light Controls");
-        ImGui::Checkbox("Enable Light", &_enabled);
-        ImGui::Checkbox("Directional (Sunlight)", &_directional);
-        ImGui::SliderFloat3("Position (XYZ)", _pos.ptr(), -200.0f, 200.0f, "%.1f");
-        ImGui::SliderFloat3("Direction", _dir.ptr(), -1.0f, 1.0f, "%.2f");
-        ImGui::ColorEdit3("Ambient", _ambient.ptr());
-        ImGui::ColorEdit3("Diffuse", _diffuse.ptr());
-        ImGui::ColorEdit3("Specular", _specular.ptr());
-
-        osg::Light* light = _lightSrc->getLight();
-        if (_directional)
-            light->setPosition(osg::Vec4(_dir, 0.0f));
-        else
-            light->setPosition(osg::Vec4(_pos, 1.0f));
-
-        light->setAmbient(_ambient);
-        light->setDiffuse(_diffuse);
-        light->setSpecular(_specular);
-        if (_enabled)
-            _lightSrc->setLocalStateSetModes(osg::StateAttribute::ON);
-        else
-            _lightSrc->setLocalStateSetModes(osg::StateAttribute::OFF);
-
-        if (_symbolXform.valid())
-        {
-            osg::Matrix M;
-            if (_directional)
-            {
-                osg::Vec3 dir = _dir; dir.normalize();
-                osg::Matrix R = osg::Matrix::rotate(osg::Vec3(0, 0, -1), dir);
-                M = R * osg::Matrix::translate(_pos);
-            }
-            else
-                M = osg::Matrix::translate(_pos);
-            _symbolXform->setMatrix(M);
-        }
+        if (ImGui::Checkbox("Enable Light", &_enabled->edit()))
+            _enabled->changed();
 
+        Placement& p = _placement->edit();
+        bool moved = ImGui::Checkbox("Directional (Sunlight)", &p.directional);
+        moved |= ImGui::SliderFloat3("Position (XYZ)", p.pos.ptr(), -200.0f, 200.0f, "%.1f");
+        moved |= ImGui::SliderFloat3("Direction", p.dir.ptr(), -1.0f, 1.0f, "%.2f");
+        if (moved)
+            _placement->changed();
+
+        if (ImGui::ColorEdit3("Ambient", _ambient->edit().ptr()))
+            _ambient->changed();
+        if (ImGui::ColorEdit3("Diffuse", _diffuse->edit().ptr()))
+            _diffuse->changed();
+        if (ImGui::ColorEdit3("Specular", _specular->edit().ptr()))
+            _specular->changed();
         ImGui::End();
     }
 
 private:
-    osg::observer_ptr<osg::LightSource> _lightSrc;
-    osg::observer_ptr<osg::MatrixTransform> _symbolXform;
-    osg::Vec3 _pos, _dir;
-    osg::Vec4 _ambient, _diffuse, _specular;
-    bool _directional, _enabled;
+    // Light position, symbol and sky all derive from these together
+    struct Placement
+    {
+        bool directional;
+        osg::Vec3 pos, dir;
+    };
+
+    osg::ref_ptr<PropertySet> _properties;
+    PropertySet::Property<Placement>* _placement;
+    PropertySet::Property<bool>* _enabled;
+    PropertySet::Property<osg::Vec4>* _ambient;
+    PropertySet::Property<osg::Vec4>* _diffuse;
+    PropertySet::Property<osg::Vec4>* _specular;
 };
 
-// -------------------- Create Sky Dome --------------------
-osg::ref_ptr<osg::Geode> createSkyDome(float radius = 500.0f, int segments = 32)
+// -------------------- Sky --------------------
+// One triangle covering the screen, placed at the far plane in the vertex
+// shader; the fragment shader turns each pixel's view ray into a sky
+// colour. There is no dome radius to clip against and nothing to rebuild
+// when the sun moves, only the sunDirection uniform changes.
+//
+// The sky is drawn after the opaque bins with depth test LEQUAL and no
+// depth writes, so pixels already covered by geometry are rejected before
+// shading. Its bounding box is empty: it is never culled and does not
+// affect the computed near/far planes.
+struct NoBoundingBox : public osg::Drawable::ComputeBoundingBoxCallback
 {
-    osg::ref_ptr<osg::Geometry> geom = new osg::Geometry();
-    osg::ref_ptr<osg::Vec3Array> verts = new osg::Vec3Array();
-    osg::ref_ptr<osg::Vec4Array> cols = new osg::Vec4Array();
+    osg::BoundingBox computeBound(const osg::Drawable&) const override { return osg::BoundingBox(); }
+};
 
-    // Create hemisphere pointing downward (since -Z is up)
-    for (int i = 0; i <= segments / 2; ++i)
-    {
-        float theta = osg::PI * 0.5f * (float)i / (segments / 2); // 0..π/2
-        float z = -radius * sin(theta);
-        float r = radius * cos(theta);
-        for (int j = 0; j <= segments; ++j)
-        {
-            float phi = 2.0f * osg::PI * (float)j / segments;
-            float x = r * cos(phi);
-            float y = r * sin(phi);
-            verts->push_back(osg::Vec3(x, y, z - 200.0f)); // center at z=-200
-            float t = (float)i / (segments / 2);
-            osg::Vec4 color(0.3f + 0.2f*t, 0.5f + 0.3f*t, 1.0f, 1.0f);
-            cols->push_back(color);
-        }
-    }
+osg::ref_ptr<osg::Geode> createSky(osg::Uniform* sunDirection)
+{
+    // Clip-space corners; (-1,-1) (3,-1) (-1,3) covers the whole viewport
+    osg::ref_ptr<osg::Vec3Array> verts = new osg::Vec3Array();
+    verts->push_back(osg::Vec3(-1.0f, -1.0f, 0.0f));
+    verts->push_back(osg::Vec3(3.0f, -1.0f, 0.0f));
+    verts->push_back(osg::Vec3(-1.0f, 3.0f, 0.0f));
 
+    osg::ref_ptr<osg::Geometry> geom = new osg::Geometry();
     geom->setVertexArray(verts);
-    geom->setColorArray(cols, osg::Array::BIND_PER_VERTEX);
+    geom->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLES, 0, 3));
+    geom->setComputeBoundingBoxCallback(new NoBoundingBox);
 
-    osg::ref_ptr<osg::DrawElementsUInt> indices = new osg::DrawElementsUInt(GL_TRIANGLES);
-    int colsCount = segments + 1;
-    for (int i = 0; i < segments / 2; ++i)
-    {
-        for (int j = 0; j < segments; ++j)
-        {
-            int a = i * colsCount + j;
-            int b = (i + 1) * colsCount + j;
-            int c = (i + 1) * colsCount + (j + 1);
-            int d = i * colsCount + (j + 1);
-            indices->push_back(a); indices->push_back(b); indices->push_back(d);
-            indices->push_back(b); indices->push_back(c); indices->push_back(d);
-        }
-    }
-    geom->addPrimitiveSet(indices);
+    static const char* vertSrc =
+        "#version 120\n"
+        "uniform mat4 osg_ViewMatrixInverse;\n"
+        "varying vec3 viewRay;\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(gl_Vertex.xy, 1.0, 1.0);\n"
+        "    vec4 eye = gl_ProjectionMatrixInverse * gl_Position;\n"
+        "    viewRay = mat3(osg_ViewMatrixInverse) * (eye.xyz / eye.w);\n"
+        "}\n";
+    // World is NED: up is -Z. Gradient from horizon to zenith, darkened
+    // as the sun sets, plus a sun disk and a forward-scattering glow.
+    static const char* fragSrc =
+        "#version 120\n"
+        "uniform vec3 sunDirection;\n"
+        "varying vec3 viewRay;\n"
+        "void main()\n"
+        "{\n"
+        "    vec3 dir = normalize(viewRay);\n"
+        "    vec3 sun = normalize(sunDirection);\n"
+        "    float h = -dir.z;\n"
+        "    float day = smoothstep(-0.15, 0.25, -sun.z);\n"
+        "    vec3 zenith = mix(vec3(0.01, 0.02, 0.06), vec3(0.15, 0.35, 0.8), day);\n"
+        "    vec3 horizon = mix(vec3(0.05, 0.05, 0.1), vec3(0.65, 0.75, 0.9), day);\n"
+        "    vec3 ground = mix(vec3(0.02, 0.02, 0.03), vec3(0.3, 0.3, 0.32), day);\n"
+        "    vec3 sky = h > 0.0 ? mix(horizon, zenith, pow(h, 0.5)) : mix(horizon, ground, sqrt(-h));\n"
+        "    float mu = max(dot(dir, sun), 0.0);\n"
+        "    vec3 sunset = mix(vec3(1.0, 0.45, 0.15), vec3(1.0, 0.95, 0.85), smoothstep(0.0, 0.4, -sun.z));\n"
+        "    sky += sunset * (0.35 * pow(mu, 8.0) + 0.6 * pow(mu, 64.0)) * smoothstep(-0.3, 0.0, -sun.z);\n"
+        "    sky += sunset * smoothstep(0.9995, 0.9998, mu);\n"
+        "    gl_FragColor = vec4(sky, 1.0);\n"
+        "}\n";
 
-    osg::ref_ptr<osg::Geode> dome = new osg::Geode();
-    dome->addDrawable(geom);
-    osg::StateSet* ss = dome->getOrCreateStateSet();
+    osg::ref_ptr<osg::Program> program = new osg::Program;
+    program->addShader(new osg::Shader(osg::Shader::VERTEX, vertSrc));
+    program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragSrc));
+
+    osg::ref_ptr<osg::Geode> sky = new osg::Geode();
+    sky->addDrawable(geom);
+    // sunDirection is rewritten in update while the last frame may be drawing
+    osg::StateSet* ss = sky->getOrCreateStateSet();
+    ss->setDataVariance(osg::Object::DYNAMIC);
+    ss->setAttributeAndModes(program);
+    ss->addUniform(sunDirection);
     ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
-    return dome;
+    ss->setAttributeAndModes(new osg::Depth(osg::Depth::LEQUAL, 0.0, 1.0, false));
+    ss->setRenderBinDetails(9, "RenderBin"); // after opaque, before transparent (10)
+    return sky;
 }
 
 // -------------------- Main --------------------
@@ -203,10 +287,14 @@ int main(int, char**)
     osg::ref_ptr<osg::Group> root = new osg::Group();
     root->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::ON);
 
+    // UI actions, run at the start of each update traversal
+    osg::ref_ptr<CommandQueue> commands = new CommandQueue;
+    root->addUpdateCallback(commands);
+
     // --- Light setup ---
     osg::ref_ptr<osg::Light> light = new osg::Light;
     light->setLightNum(0);
-    light->setPosition(osg::Vec4(0.0f, 0.0f, 1.0f, 0.0f));
+    light->setPosition(osg::Vec4(0.4f, 0.3f, -0.6f, 0.0f));
     light->setAmbient(osg::Vec4(0.2f, 0.2f, 0.2f, 1.0f));
     light->setDiffuse(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f));
     light->setSpecular(osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f));
@@ -234,17 +322,18 @@ int main(int, char**)
     // --- Axes ---
     root->addChild(createAxes(20.0f));
 
-    // --- Sky Dome ---
-    osg::ref_ptr<osg::Geode> sky = createSkyDome(500.0f, 48);
-    root->addChild(sky);
+    // --- Sky ---
+    osg::ref_ptr<osg::Uniform> sunDirection = new osg::Uniform("sunDirection", osg::Vec3(0.4f, 0.3f, -0.6f));
+    sunDirection->setDataVariance(osg::Object::DYNAMIC);
+    root->addChild(createSky(sunDirection.get()));
 
     // --- Viewer ---
     osgViewer::Viewer viewer;
     viewer.apply(new osgViewer::SingleWindow(100, 100, 1000, 700));
     viewer.setSceneData(root);
     viewer.setRealizeOperation(new ImGuiInitOperation);
-    viewer.addEventHandler(new ImGuiControl());
-    viewer.addEventHandler(new LightControl(lightSrc.get(), lightSymbolXform.get()));
+    viewer.addEventHandler(new ImGuiControl(commands.get()));
+    viewer.addEventHandler(new LightControl(lightSrc.get(), lightSymbolXform.get(), sunDirection.get()));
 
     return viewer.run();
 }
@@ -0,0 +1,330 @@
+#pragma once
+#include <osg/NodeCallback>
+#include <osg/NodeVisitor>
+#include <osg/Stats>
+#include <osg/Timer>
+#include <osgViewer/Viewer>
+#include <osgViewer/ViewerEventHandlers>
+#include <imgui.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// ProfileZones
+// ------------
+// Scoped hot-path timers. PROFILE_ZONE("name") records an osg::Timer tick
+// pair (same time base as osg::Stats) into a per-thread ring buffer; the
+// only cost on the hot path is two tick() reads and one ring write.
+//
+// Once per frame ProfileCollectCallback drains every ring, sums the zones
+// per frame and writes them to the viewer stats as
+//   "<zone> time taken" / "<zone> begin time" / "<zone> end time"
+// so they show up as extra lines in the StatsHandler ('s' key). The same
+// data feeds drawProfilerPanel() and exportChromeTrace().
+//
+// Zone names must be string literals (only the pointer is stored).
+//
+struct ProfileEvent
+{
+    const char *name;
+    osg::Timer_t begin;
+    osg::Timer_t end;
+    unsigned int frame;
+    unsigned int thread;
+};
+
+// Single producer (owning thread) / single consumer (collector) ring
+class ProfileRing
+{
+public:
+    static const size_t CAPACITY = 4096;
+
+    explicit ProfileRing(unsigned int thread) : _thread(thread) {}
+
+    void push(const char *name, osg::Timer_t begin, osg::Timer_t end, unsigned int frame)
+    {
+        const uint64_t head = _head.load(std::memory_order_relaxed);
+        _events[head % CAPACITY] = {name, begin, end, frame, _thread};
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename F>
+    void drain(F &&f)
+    {
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        if (head - _tail > CAPACITY)
+            _tail = head - CAPACITY; // producer lapped us; oldest events are lost
+        for (; _tail < head; ++_tail)
+            f(_events[_tail % CAPACITY]);
+    }
+
+private:
+    ProfileEvent _events[CAPACITY];
+    std::atomic<uint64_t> _head{0};
+    uint64_t _tail = 0;
+    unsigned int _thread;
+};
+
+class Profiler
+{
+public:
+    struct ZoneSummary
+    {
+        const char *name;
+        unsigned int frame = 0;
+        double lastMs = 0.0;
+        double avgMs = 0.0;
+        double beginMs = 0.0; // relative to the earliest zone of that frame
+        double endMs = 0.0;
+    };
+
+    static Profiler &instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // Ring of the calling thread, created on first use
+    ProfileRing &threadRing()
+    {
+        thread_local ProfileRing *ring = nullptr;
+        if (!ring)
+        {
+            std::lock_guard<std::mutex> lock(_ringsMutex);
+            _rings.emplace_back(new ProfileRing(static_cast<unsigned int>(_rings.size())));
+            ring = _rings.back().get();
+        }
+        return *ring;
+    }
+
+    unsigned int frame() const { return _frame.load(std::memory_order_relaxed); }
+    void setFrame(unsigned int frame) { _frame.store(frame, std::memory_order_relaxed); }
+
+    // Drains all rings into per-frame zone totals; call from one thread only
+    void collect(osg::Stats *stats, osg::Timer_t startTick)
+    {
+        std::vector<ProfileEvent> drained;
+        {
+            std::lock_guard<std::mutex> lock(_ringsMutex);
+            for (auto &ring : _rings)
+                ring->drain([&](const ProfileEvent &e) { drained.push_back(e); });
+        }
+        if (drained.empty())
+            return;
+
+        // Sum repeated zones within a frame (e.g. one callback per entity)
+        struct Total
+        {
+            osg::Timer_t begin, end;
+            double seconds;
+        };
+        std::map<std::pair<unsigned int, const char *>, Total> totals;
+        const osg::Timer *timer = osg::Timer::instance();
+        for (const ProfileEvent &e : drained)
+        {
+            auto it = totals.find({e.frame, e.name});
+            const double s = timer->delta_s(e.begin, e.end);
+            if (it == totals.end())
+                totals[{e.frame, e.name}] = {e.begin, e.end, s};
+            else
+            {
+                it->second.begin = std::min(it->second.begin, e.begin);
+                it->second.end = std::max(it->second.end, e.end);
+                it->second.seconds += s;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(_summaryMutex);
+        std::map<unsigned int, osg::Timer_t> frameStart;
+        for (const auto &kv : totals)
+        {
+            auto fs = frameStart.find(kv.first.first);
+            if (fs == frameStart.end() || kv.second.begin < fs->second)
+                frameStart[kv.first.first] = kv.second.begin;
+        }
+        for (const auto &kv : totals)
+        {
+            const unsigned int frame = kv.first.first;
+            const std::string name = kv.first.second;
+            const Total &t = kv.second;
+            if (stats)
+            {
+                stats->setAttribute(frame, name + " time taken", t.seconds);
+                stats->setAttribute(frame, name + " begin time", timer->delta_s(startTick, t.begin));
+                stats->setAttribute(frame, name + " end time", timer->delta_s(startTick, t.end));
+            }
+
+            ZoneSummary &z = summary(kv.first.second);
+            if (frame >= z.frame)
+            {
+                z.frame = frame;
+                z.lastMs = t.seconds * 1000.0;
+                z.avgMs = z.avgMs * 0.95 + z.lastMs * 0.05;
+                z.beginMs = timer->delta_m(frameStart[frame], t.begin);
+                z.endMs = timer->delta_m(frameStart[frame], t.end);
+            }
+        }
+
+        _history.insert(_history.end(), drained.begin(), drained.end());
+        if (_history.size() > MAX_HISTORY)
+            _history.erase(_history.begin(), _history.begin() + (_history.size() - MAX_HISTORY));
+    }
+
+    std::vector<ZoneSummary> zones() const
+    {
+        std::lock_guard<std::mutex> lock(_summaryMutex);
+        return _zones;
+    }
+
+    // Chrome trace event format (chrome://tracing, Perfetto)
+    bool exportChromeTrace(const std::string &file) const
+    {
+        std::ofstream out(file);
+        if (!out)
+        {
+            std::cerr << "Cannot open " << file << "\n";
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(_summaryMutex);
+        const osg::Timer *timer = osg::Timer::instance();
+        const osg::Timer_t origin = _history.empty() ? 0 : _history.front().begin;
+        out << "{\"traceEvents\":[\n";
+        for (size_t i = 0; i < _history.size(); ++i)
+        {
+            const ProfileEvent &e = _history[i];
+            out << (i ? ",\n" : "")
+                << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+                << ",\"ts\":" << timer->delta_u(origin, e.begin)
+                << ",\"dur\":" << timer->delta_u(e.begin, e.end)
+                << ",\"args\":{\"frame\":" << e.frame << "}}";
+        }
+        out << "\n]}\n";
+        std::cout << "Chrome trace written: " << file << " (" << _history.size() << " events)\n";
+        return bool(out);
+    }
+
+private:
+    static const size_t MAX_HISTORY = 200000;
+
+    ZoneSummary &summary(const char *name)
+    {
+        for (ZoneSummary &z : _zones)
+        {
+            if (z.name == name)
+                return z;
+        }
+        _zones.push_back(ZoneSummary{name});
+        return _zones.back();
+    }
+
+    std::atomic<unsigned int> _frame{0};
+
+    std::mutex _ringsMutex;
+    std::vector<std::unique_ptr<ProfileRing>> _rings;
+
+    mutable std::mutex _summaryMutex;
+    std::vector<ZoneSummary> _zones;
+    std::deque<ProfileEvent> _history;
+};
+
+// ======================= Scoped Zone ===========================
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char *name)
+        : _name(name), _begin(osg::Timer::instance()->tick()) {}
+
+    ~ProfileZone()
+    {
+        Profiler &p = Profiler::instance();
+        p.threadRing().push(_name, _begin, osg::Timer::instance()->tick(), p.frame());
+    }
+
+private:
+    const char *_name;
+    osg::Timer_t _begin;
+};
+
+#define PROFILE_ZONE_CAT2(a, b) a##b
+#define PROFILE_ZONE_CAT(a, b) PROFILE_ZONE_CAT2(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CAT(_profileZone, __LINE__)(name)
+
+// ======================= Collector ===========================
+// Install as the root update callback: stamps the frame number for new
+// zones and publishes everything recorded so far to the viewer stats
+class ProfileCollectCallback : public osg::NodeCallback
+{
+public:
+    explicit ProfileCollectCallback(osgViewer::Viewer *viewer) : _viewer(viewer) {}
+
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        Profiler &p = Profiler::instance();
+        if (nv->getFrameStamp())
+            p.setFrame(nv->getFrameStamp()->getFrameNumber());
+        if (_viewer)
+            p.collect(_viewer->getViewerStats(), _viewer->getStartTick());
+        traverse(node, nv);
+    }
+
+private:
+    osgViewer::Viewer *_viewer;
+};
+
+// One StatsHandler line per zone; names must match the PROFILE_ZONE literals
+inline void addProfileStatsLines(osgViewer::StatsHandler *handler, const std::vector<std::string> &zones)
+{
+    const osg::Vec4 colors[] = {{1.0f, 0.6f, 0.2f, 1.0f}, {0.4f, 0.8f, 1.0f, 1.0f},
+                                {0.6f, 1.0f, 0.4f, 1.0f}, {1.0f, 0.4f, 0.8f, 1.0f}};
+    for (size_t i = 0; i < zones.size(); ++i)
+    {
+        const osg::Vec4 &c = colors[i % 4];
+        handler->addUserStatsLine(zones[i], c, c, zones[i] + " time taken", 1000.0, true, false,
+                                  zones[i] + " begin time", zones[i] + " end time", 2.0);
+    }
+}
+
+// ======================= ImGui Panel ===========================
+// Per-zone timings plus a timeline of the last collected frame
+inline void drawProfilerPanel()
+{
+    const std::vector<Profiler::ZoneSummary> zones = Profiler::instance().zones();
+
+    ImGui::Begin("Profiler");
+    if (ImGui::Button("Export Chrome Trace"))
+        Profiler::instance().exportChromeTrace("profile_trace.json");
+
+    double span = 0.0;
+    for (const auto &z : zones)
+        span = std::max(span, z.endMs);
+    span = std::max(span, 0.001);
+
+    ImGui::Text("%-22s %8s %8s", "Zone", "last ms", "avg ms");
+    const float barWidth = ImGui::GetContentRegionAvail().x;
+    const ImU32 colors[] = {IM_COL32(255, 153, 51, 255), IM_COL32(102, 204, 255, 255),
+                            IM_COL32(153, 255, 102, 255), IM_COL32(255, 102, 204, 255)};
+    for (size_t i = 0; i < zones.size(); ++i)
+    {
+        const auto &z = zones[i];
+        ImGui::Text("%-22s %8.3f %8.3f", z.name, z.lastMs, z.avgMs);
+
+        // Timeline bar: position and width within the frame's profiled span
+        const ImVec2 p = ImGui::GetCursorScreenPos();
+        const float x0 = p.x + barWidth * float(z.beginMs / span);
+        const float x1 = std::max(x0 + 1.0f, p.x + barWidth * float(z.endMs / span));
+        ImDrawList *dl = ImGui::GetWindowDrawList();
+        dl->AddRectFilled(ImVec2(p.x, p.y), ImVec2(p.x + barWidth, p.y + 6.0f), IM_COL32(60, 60, 60, 255));
+        dl->AddRectFilled(ImVec2(x0, p.y), ImVec2(x1, p.y + 6.0f), colors[i % 4]);
+        ImGui::Dummy(ImVec2(barWidth, 8.0f));
+    }
+    ImGui::Text("Frame span: %.3f ms", span);
+    ImGui::End();
+}
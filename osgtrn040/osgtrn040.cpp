@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <osgViewer/Viewer>
 #include <osgViewer/config/SingleWindow>
+#include <osgViewer/ViewerEventHandlers>
 #include <osgGA/TrackballManipulator>
 #include <osg/MatrixTransform>
 #include <osg/Geode>
@@ -19,6 +20,7 @@
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "ProfileZones.hpp"
 
 // =============== ANSI (trimmed) ===============
 #define ANSI_RESET "\e[0;0m]"
@@ -207,6 +209,7 @@ public:
 
     void operator()(osg::Node *, osg::NodeVisitor *nv) override
     {
+        PROFILE_ZONE("F14MotionCallback");
         if (gAnim.running)
         {
             gAnim.t += gAnim.speed * 0.01f;
@@ -259,6 +262,7 @@ public:
 
     void operator()(osg::Node *, osg::NodeVisitor *nv) override
     {
+        PROFILE_ZONE("MissileMotionCallback");
         const float dt = 0.02f;
         float t0 = std::max(0.0f, gAnim.t - dt);
         float t2 = std::min(1.0f, gAnim.t + dt);
@@ -322,6 +326,7 @@ public:
 
     void operator()(osg::Node *, osg::NodeVisitor *nv) override
     {
+        PROFILE_ZONE("ChaseCameraUpdater");
         if (!viewer)
             return;
 
@@ -377,6 +382,7 @@ public:
 protected:
     void drawUi() override
     {
+        PROFILE_ZONE("drawUi");
         ImGui::Begin("Motion Controller");
 
         if (ImGui::Button(gAnim.running ? "Stop" : "Start"))
@@ -403,6 +409,8 @@ protected:
         ImGui::Combo("Mode", &gAnim.cameraMode, modes, IM_ARRAYSIZE(modes));
 
         ImGui::End();
+
+        drawProfilerPanel();
     }
 
 private:
@@ -462,5 +470,11 @@ int main(int, char **)
     // Chase updater (switches manipulator automatically)
     viewer.getCamera()->setUpdateCallback(new ChaseCameraUpdater(&viewer, f14CB, missileCB));
 
+    // Hot-path zones: collected once per frame, shown in the stats overlay ('s') and the Profiler panel
+    root->addUpdateCallback(new ProfileCollectCallback(&viewer));
+    osg::ref_ptr<osgViewer::StatsHandler> stats = new osgViewer::StatsHandler;
+    addProfileStatsLines(stats.get(), {"F14MotionCallback", "MissileMotionCallback", "ChaseCameraUpdater", "drawUi"});
+    viewer.addEventHandler(stats);
+
     return viewer.run();
 }
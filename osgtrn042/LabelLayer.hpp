@@ -0,0 +1,343 @@
+#pragma once
+#include <osg/BlendFunc>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Program>
+#include <osg/Texture2D>
+#include <osg/Uniform>
+#include <osgText/Font>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//
+// LabelLayer
+// ----------
+// All entity annotations in one Geometry / one draw call.
+//
+// * Glyphs 32..126 are rasterised once into a private atlas texture.
+// * Every label owns a fixed range of maxChars quad slots, allocated up
+//   front; text is formatted into a fixed buffer (no std::string, no
+//   ostringstream) and only slots whose character or pen position changed
+//   are rewritten.
+// * Anchors live in a uniform array with one entry per label. Each quad
+//   vertex carries its glyph corner (in em units) and its label id; the
+//   vertex shader looks the anchor up and billboards the corner in eye
+//   space. Moving a label is one uniform element write and resizing all
+//   labels is another - no vertex upload, no glyph rebuild.
+// * maxLabels sizes that array, so it must fit the vertex shader's uniform
+//   space; the default 64 needs 192 components.
+//
+class LabelLayer : public osg::Geode
+{
+public:
+    LabelLayer(const std::string &fontFile, unsigned int maxLabels = 64,
+               unsigned int maxChars = 64, unsigned int resolution = 32)
+        : _maxLabels(maxLabels), _maxChars(maxChars), _buffer(maxChars + 1, '\0')
+    {
+        buildAtlas(fontFile, resolution);
+        buildGeometry();
+        buildState();
+    }
+
+    // Returns the label id, or -1 when all labels are in use
+    int addLabel(const osg::Vec3 &anchor, const osg::Vec4 &color)
+    {
+        if (_numLabels >= _maxLabels)
+            return -1;
+        const int id = static_cast<int>(_numLabels++);
+        const unsigned int first = id * _maxChars * 4;
+        std::fill(_colors->begin() + first, _colors->begin() + first + _maxChars * 4, color);
+        _colors->dirty();
+        _anchors[id] = anchor;
+        _anchorUniform->setElement(id, anchor);
+        _geom->dirtyBound();
+        return id;
+    }
+
+    // Ids that addLabel() did not hand out, including -1, are ignored here
+    // and in setText()/format()
+    void setAnchor(int id, const osg::Vec3 &anchor)
+    {
+        if (!valid(id) || _anchors[id] == anchor)
+            return;
+        _anchors[id] = anchor;
+        _anchorUniform->setElement(id, anchor);
+        _geom->dirtyBound();
+    }
+
+    // Lays out text and rewrites only the slots that changed
+    void setText(int id, const char *text)
+    {
+        if (!valid(id))
+            return;
+
+        const float lineHeight = 1.2f;
+        float penX = 0.0f, penY = 0.0f;
+        unsigned int slot = 0;
+        bool changed = false;
+
+        for (const char *c = text; *c && slot < _maxChars; ++c)
+        {
+            if (*c == '\n')
+            {
+                penX = 0.0f;
+                penY -= lineHeight;
+                continue;
+            }
+            const unsigned char ch = (*c >= 32 && *c < 127) ? *c : '?';
+            changed |= writeSlot(id, slot++, ch, penX, penY);
+            penX += _glyphs[ch].advance;
+        }
+        // Collapse slots left over from a longer previous text
+        for (; slot < _maxChars; ++slot)
+            changed |= writeSlot(id, slot, 0, 0.0f, 0.0f);
+
+        if (changed)
+        {
+            _uvs->dirty();
+            _corners->dirty();
+        }
+    }
+
+    // printf-style setText through the layer's fixed buffer
+    void format(int id, const char *fmt, ...)
+    {
+        if (!valid(id))
+            return;
+
+        va_list args;
+        va_start(args, fmt);
+        std::vsnprintf(_buffer.data(), _buffer.size(), fmt, args);
+        va_end(args);
+        setText(id, _buffer.data());
+    }
+
+    // World units per em for every label
+    void setCharacterSize(float size) { _sizeUniform->set(size); }
+
+private:
+    struct GlyphInfo
+    {
+        osg::Vec2 uvMin, uvMax;         // atlas rectangle
+        osg::Vec2 cornerMin, cornerMax; // quad in em units relative to the pen
+        float advance = 0.0f;
+    };
+
+    struct Slot
+    {
+        unsigned char ch = 0;
+        float x = 0.0f, y = 0.0f;
+    };
+
+    bool valid(int id) const { return id >= 0 && static_cast<unsigned int>(id) < _numLabels; }
+
+    // Returns true when the slot had to be rewritten
+    bool writeSlot(int id, unsigned int index, unsigned char ch, float x, float y)
+    {
+        Slot &s = _slots[id * _maxChars + index];
+        if (s.ch == ch && s.x == x && s.y == y)
+            return false;
+        s.ch = ch;
+        s.x = x;
+        s.y = y;
+
+        const GlyphInfo &g = _glyphs[ch];
+        const unsigned int v = (id * _maxChars + index) * 4;
+        const osg::Vec2 pen(x, y);
+        const bool visible = ch > 32;
+        const float label = float(id); // z of every corner
+        (*_corners)[v + 0] = osg::Vec3(visible ? pen + g.cornerMin : pen, label);
+        (*_corners)[v + 1] = osg::Vec3(visible ? pen + osg::Vec2(g.cornerMax.x(), g.cornerMin.y()) : pen, label);
+        (*_corners)[v + 2] = osg::Vec3(visible ? pen + g.cornerMax : pen, label);
+        (*_corners)[v + 3] = osg::Vec3(visible ? pen + osg::Vec2(g.cornerMin.x(), g.cornerMax.y()) : pen, label);
+        (*_uvs)[v + 0] = g.uvMin;
+        (*_uvs)[v + 1] = osg::Vec2(g.uvMax.x(), g.uvMin.y());
+        (*_uvs)[v + 2] = g.uvMax;
+        (*_uvs)[v + 3] = osg::Vec2(g.uvMin.x(), g.uvMax.y());
+        return true;
+    }
+
+    static unsigned char coverage(const osg::Image *img, int x, int y)
+    {
+        const unsigned char *p = img->data(x, y);
+        switch (img->getPixelFormat())
+        {
+        case GL_LUMINANCE_ALPHA:
+            return p[1];
+        case GL_RGBA:
+            return p[3];
+        default: // GL_ALPHA / GL_RED / GL_LUMINANCE
+            return p[0];
+        }
+    }
+
+    void buildAtlas(const std::string &fontFile, unsigned int res)
+    {
+        osg::ref_ptr<osgText::Font> font = osgText::readRefFontFile(fontFile);
+        if (!font)
+            font = osgText::Font::getDefaultFont();
+
+        const int cols = 16, rows = 6; // 96 glyphs, 32..127
+        const int cell = static_cast<int>(res) + 2;
+        osg::ref_ptr<osg::Image> atlas = new osg::Image;
+        atlas->allocateImage(cols * cell, rows * cell, 1, GL_ALPHA, GL_UNSIGNED_BYTE);
+        std::memset(atlas->data(), 0, atlas->getTotalSizeInBytes());
+
+        const float W = float(atlas->s()), H = float(atlas->t());
+        for (unsigned int ch = 32; ch < 127; ++ch)
+        {
+            osgText::Glyph *glyph = font->getGlyph(osgText::FontResolution(res, res), ch);
+            if (!glyph)
+                continue;
+
+            const int ox = int((ch - 32) % cols) * cell + 1;
+            const int oy = int((ch - 32) / cols) * cell + 1;
+            const int gw = std::min(glyph->s(), cell - 2);
+            const int gh = std::min(glyph->t(), cell - 2);
+            if (glyph->data())
+            {
+                for (int y = 0; y < gh; ++y)
+                    for (int x = 0; x < gw; ++x)
+                        *atlas->data(ox + x, oy + y) = coverage(glyph, x, y);
+            }
+
+            // Bearing and advance are normalised to the em by osgText
+            GlyphInfo &g = _glyphs[ch];
+            g.uvMin.set(ox / W, oy / H);
+            g.uvMax.set((ox + gw) / W, (oy + gh) / H);
+            g.cornerMin = glyph->getHorizontalBearing();
+            g.cornerMax = g.cornerMin + osg::Vec2(float(gw) / res, float(gh) / res);
+            g.advance = glyph->getHorizontalAdvance();
+        }
+
+        _atlas = new osg::Texture2D(atlas.get());
+        _atlas->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        _atlas->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        _atlas->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        _atlas->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+        _atlas->setResizeNonPowerOfTwoHint(false);
+    }
+
+    void buildGeometry()
+    {
+        const unsigned int numSlots = _maxLabels * _maxChars;
+        _slots.resize(numSlots);
+        _anchors.resize(_maxLabels);
+
+        _corners = new osg::Vec3Array(numSlots * 4);
+        _uvs = new osg::Vec2Array(numSlots * 4);
+        _colors = new osg::Vec4Array(numSlots * 4);
+        for (unsigned int v = 0; v < numSlots * 4; ++v)
+            (*_corners)[v].z() = float(v / (_maxChars * 4));
+
+        osg::ref_ptr<osg::DrawElementsUInt> quads = new osg::DrawElementsUInt(GL_TRIANGLES);
+        quads->reserve(numSlots * 6);
+        for (unsigned int i = 0; i < numSlots; ++i)
+        {
+            const unsigned int v = i * 4;
+            quads->push_back(v + 0);
+            quads->push_back(v + 1);
+            quads->push_back(v + 2);
+            quads->push_back(v + 0);
+            quads->push_back(v + 2);
+            quads->push_back(v + 3);
+        }
+
+        _geom = new osg::Geometry;
+        _geom->setUseDisplayList(false);
+        _geom->setUseVertexBufferObjects(true);
+        _geom->setDataVariance(osg::Object::DYNAMIC);
+        _geom->setVertexArray(_corners.get());
+        _geom->setColorArray(_colors.get(), osg::Array::BIND_PER_VERTEX);
+        _geom->setTexCoordArray(0, _uvs.get(), osg::Array::BIND_PER_VERTEX);
+        _geom->addPrimitiveSet(quads.get());
+        _geom->setComputeBoundingBoxCallback(new LabelBoundsCallback(this));
+        addDrawable(_geom.get());
+    }
+
+    void buildState()
+    {
+        const std::string vertSrc =
+            "#version 120\n"
+            "uniform float labelSize;\n"
+            "uniform vec3 labelAnchors[" + std::to_string(_maxLabels) + "];\n"
+            "void main()\n"
+            "{\n"
+            "    vec4 eye = gl_ModelViewMatrix * vec4(labelAnchors[int(gl_Vertex.z)], 1.0);\n"
+            "    eye.xy += gl_Vertex.xy * labelSize;\n"
+            "    gl_Position = gl_ProjectionMatrix * eye;\n"
+            "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+            "    gl_FrontColor = gl_Color;\n"
+            "}\n";
+        static const char *fragSrc =
+            "#version 120\n"
+            "uniform sampler2D glyphAtlas;\n"
+            "void main()\n"
+            "{\n"
+            "    float a = texture2D(glyphAtlas, gl_TexCoord[0].st).a;\n"
+            "    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * a);\n"
+            "}\n";
+
+        osg::ref_ptr<osg::Program> program = new osg::Program;
+        program->addShader(new osg::Shader(osg::Shader::VERTEX, vertSrc));
+        program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragSrc));
+
+        _sizeUniform = new osg::Uniform("labelSize", 10.0f);
+        _anchorUniform = new osg::Uniform(osg::Uniform::FLOAT_VEC3, "labelAnchors", _maxLabels);
+        for (unsigned int i = 0; i < _maxLabels; ++i)
+            _anchorUniform->setElement(i, osg::Vec3());
+
+        osg::StateSet *ss = getOrCreateStateSet();
+        ss->setAttributeAndModes(program.get(), osg::StateAttribute::ON);
+        ss->setTextureAttributeAndModes(0, _atlas.get(), osg::StateAttribute::ON);
+        ss->addUniform(new osg::Uniform("glyphAtlas", 0));
+        ss->addUniform(_sizeUniform.get());
+        ss->addUniform(_anchorUniform.get());
+        ss->setAttributeAndModes(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), osg::StateAttribute::ON);
+        ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        ss->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+    }
+
+    // Anchors only; grown by the largest possible label extent so culling stays conservative
+    struct LabelBoundsCallback : public osg::Drawable::ComputeBoundingBoxCallback
+    {
+        explicit LabelBoundsCallback(LabelLayer *layer) : _layer(layer) {}
+
+        osg::BoundingBox computeBound(const osg::Drawable &) const override
+        {
+            osg::BoundingBox bb;
+            float size = 10.0f;
+            _layer->_sizeUniform->get(size);
+            const float extent = size * float(_layer->_maxChars);
+            for (unsigned int i = 0; i < _layer->_numLabels; ++i)
+            {
+                const osg::Vec3 &a = _layer->_anchors[i];
+                bb.expandBy(a - osg::Vec3(extent, extent, extent));
+                bb.expandBy(a + osg::Vec3(extent, extent, extent));
+            }
+            return bb;
+        }
+
+        LabelLayer *_layer;
+    };
+
+    unsigned int _maxLabels;
+    unsigned int _maxChars;
+    unsigned int _numLabels = 0;
+    std::vector<char> _buffer;
+    std::vector<Slot> _slots;
+    std::vector<osg::Vec3> _anchors; // mirrors labelAnchors for the bound
+    GlyphInfo _glyphs[128];
+
+    osg::ref_ptr<osg::Geometry> _geom;
+    osg::ref_ptr<osg::Vec3Array> _corners;
+    osg::ref_ptr<osg::Vec2Array> _uvs;
+    osg::ref_ptr<osg::Vec4Array> _colors;
+    osg::ref_ptr<osg::Texture2D> _atlas;
+    osg::ref_ptr<osg::Uniform> _sizeUniform;
+    osg::ref_ptr<osg::Uniform> _anchorUniform;
+};
@@ -1,27 +1,27 @@
 #include <osg/Group>
 #include <osg/Geode>
-#include <osgText/Text>
 #include <osg/PositionAttitudeTransform>
 #include <osgViewer/Viewer>
 #include <osgDB/ReadFile>
 #include <osg/MatrixTransform>
-#include <osg/Timer>
 #include <cmath>
-#include <sstream>
+
+#include "LabelLayer.hpp"
 
 // ========================= Animation Callback =========================
 class CessnaUpdateCallback : public osg::NodeCallback
 {
 public:
-    CessnaUpdateCallback(osgText::Text* text)
-        : _text(text), _startTime(osg::Timer::instance()->time_s()) {}
+    CessnaUpdateCallback(LabelLayer* labels, int label)
+        : _labels(labels), _label(label) {}
 
     void operator()(osg::Node* node, osg::NodeVisitor* nv) override
     {
         osg::PositionAttitudeTransform* pat = dynamic_cast<osg::PositionAttitudeTransform*>(node);
         if (!pat) return;
 
-        double t = osg::Timer::instance()->time_s() - _startTime;
+        // Frame-stamp time, so viewer.frame(t) can replay a run exactly
+        double t = nv->getFrameStamp()->getSimulationTime();
 
         // Circular motion parameters
         float radius = 100.0f;
@@ -42,19 +42,12 @@ public:
         rot.makeRotate(yaw, osg::Vec3(0, 0, 1));
         pat->setAttitude(rot);
 
-        // Update text position (slightly above the plane)
-        if (_text.valid())
+        // Update label (slightly above the plane); formats into the layer's
+        // fixed buffer and only rewrites the glyphs that changed
+        if (_labels.valid())
         {
-            _text->setPosition(osg::Vec3(x, y + 20.0f, z + 20.0f));
-
-            std::ostringstream ss;
-            ss.setf(std::ios::fixed);
-            ss.precision(2);
-            ss << "Cessna\n"
-               << "X: " << x << "\n"
-               << "Y: " << y << "\n"
-               << "Z: " << z;
-            _text->setText(ss.str());
+            _labels->setAnchor(_label, osg::Vec3(x, y + 20.0f, z + 20.0f));
+            _labels->format(_label, "Cessna\nX: %.2f\nY: %.2f\nZ: %.2f", x, y, z);
         }
 
         // Continue traversing
@@ -62,8 +55,8 @@ public:
     }
 
 private:
-    osg::observer_ptr<osgText::Text> _text;
-    double _startTime;
+    osg::observer_ptr<LabelLayer> _labels;
+    int _label;
 };
 
 // ========================= Main =========================
@@ -88,19 +81,14 @@ int main(int argc, char** argv)
     osg::ref_ptr<osg::PositionAttitudeTransform> cessnaXform = new osg::PositionAttitudeTransform();
     cessnaXform->addChild(cessna);
 
-    // Text
-    osg::ref_ptr<osgText::Text> text = new osgText::Text();
-    text->setFont("fonts/arial.ttf");
-    text->setCharacterSize(10.0f);
-    text->setAxisAlignment(osgText::TextBase::SCREEN);
-    text->setColor(osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f));
-
-    osg::ref_ptr<osg::Geode> textGeode = new osg::Geode();
-    textGeode->addDrawable(text);
-    root->addChild(textGeode);
+    // Labels: every entity annotation shares one batched layer
+    osg::ref_ptr<LabelLayer> labels = new LabelLayer("fonts/arial.ttf", 64, 48);
+    labels->setCharacterSize(10.0f);
+    int cessnaLabel = labels->addLabel(osg::Vec3(), osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f));
+    root->addChild(labels);
 
-    // Add callback for motion and text update
-    cessnaXform->setUpdateCallback(new CessnaUpdateCallback(text));
+    // Add callback for motion and label update
+    cessnaXform->setUpdateCallback(new CessnaUpdateCallback(labels, cessnaLabel));
 
     root->addChild(cessnaXform);
     viewer.setSceneData(root);
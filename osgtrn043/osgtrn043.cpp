@@ -5,7 +5,6 @@
 #include <osgViewer/Viewer>
 #include <osgDB/ReadFile>
 #include <osg/MatrixTransform>
-#include <osg/Timer>
 #include <cmath>
 #include <sstream>
 
@@ -13,14 +12,15 @@
 class CessnaUpdateCallback : public osg::NodeCallback
 {
 public:
-    CessnaUpdateCallback() : _startTime(osg::Timer::instance()->time_s()) {}
+    CessnaUpdateCallback() {}
 
     void operator()(osg::Node* node, osg::NodeVisitor* nv) override
     {
         osg::PositionAttitudeTransform* pat = dynamic_cast<osg::PositionAttitudeTransform*>(node);
         if (!pat) return;
 
-        double t = osg::Timer::instance()->time_s() - _startTime;
+        // Frame-stamp time, so viewer.frame(t) can replay a run exactly
+        double t = nv->getFrameStamp()->getSimulationTime();
 
         // Circular motion parameters
         float radius = 100.0f;
@@ -44,9 +44,6 @@ public:
         // Continue traversing
         traverse(node, nv);
     }
-
-private:
-    double _startTime;
 };
 
 // ========================= Main =========================
@@ -0,0 +1,209 @@
+#pragma once
+#include <osg/NodeCallback>
+#include <osg/Viewport>
+#include <osgGA/GUIEventHandler>
+#include <osgUtil/CullVisitor>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "LabelLayer.hpp"
+
+//
+// LabelDeclutter
+// --------------
+// Cull callback for a LabelLayer that hides overlapping labels.
+//
+// Every frame the label anchors are projected with the cull visitor's
+// matrices and each label's pixel rectangle is built from its em extent,
+// using the same em size the label shader computes. Labels behind the eye
+// or fully off screen are dropped. The rest are taken in priority order
+// (ties: nearer first) and tested against the labels already placed via a
+// uniform screen grid, so each test only looks at the few rectangles in the
+// cells it covers. Survivors stay in the layer's index buffer; the others
+// are not drawn at all.
+//
+// All scratch buffers are members and only grow, so a steady frame does
+// not allocate.
+//
+class LabelDeclutter : public osg::NodeCallback
+{
+public:
+    explicit LabelDeclutter(LabelLayer *layer, float cellPixels = 64.0f, float marginPixels = 2.0f)
+        : _layer(layer), _cellPixels(cellPixels), _margin(marginPixels) {}
+
+    // Higher priority labels win overlaps
+    void setPriority(int id, int priority)
+    {
+        if (id >= int(_priorities.size()))
+            _priorities.resize(id + 1, 0);
+        _priorities[id] = priority;
+    }
+
+    void setEnabled(bool enabled) { _enabled = enabled; }
+    bool isEnabled() const { return _enabled; }
+
+    unsigned int numVisible() const { return _numVisible; }
+
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        osgUtil::CullVisitor *cv = nv->asCullVisitor();
+        if (cv && cv->getViewport() && _layer.valid())
+        {
+            const osg::RefMatrix &proj = *cv->getProjectionMatrix();
+            declutter(*cv->getModelViewMatrix() * proj, proj(1, 1), *cv->getViewport());
+        }
+        traverse(node, nv);
+    }
+
+    // Toggles decluttering with the 'd' key
+    class ToggleHandler : public osgGA::GUIEventHandler
+    {
+    public:
+        explicit ToggleHandler(LabelDeclutter *declutter) : _declutter(declutter) {}
+
+        bool handle(const osgGA::GUIEventAdapter &ea, osgGA::GUIActionAdapter &) override
+        {
+            if (ea.getEventType() != osgGA::GUIEventAdapter::KEYDOWN || ea.getKey() != 'd')
+                return false;
+            _declutter->setEnabled(!_declutter->isEnabled());
+            return true;
+        }
+
+    private:
+        osg::ref_ptr<LabelDeclutter> _declutter;
+    };
+
+private:
+    struct Candidate
+    {
+        int id;
+        int priority;
+        float depth;
+        float x0, y0, x1, y1; // pixels
+    };
+
+    void declutter(const osg::Matrix &mvp, double projScaleY, const osg::Viewport &vp)
+    {
+        const float width = float(vp.width()), height = float(vp.height());
+        const float size = _layer->characterSize();
+        const osg::Vec2 range = _layer->pixelSizeRange();
+        const unsigned int n = _layer->numLabels();
+
+        // --- Project: anchor -> pixel rectangle ---
+        _candidates.clear();
+        for (unsigned int id = 0; id < n; ++id)
+        {
+            const osg::Vec4 clip = osg::Vec4(_layer->anchor(id), 1.0f) * mvp;
+            if (clip.w() <= 1e-6f)
+            {
+                _layer->setVisible(id, false);
+                continue;
+            }
+
+            // Mirrors the label vertex shader
+            const float pixelsPerUnit = float(projScaleY) * 0.5f * height / clip.w();
+            const float em = std::min(std::max(size * pixelsPerUnit, range.x()), range.y());
+            const float sx = (clip.x() / clip.w() * 0.5f + 0.5f) * width;
+            const float sy = (clip.y() / clip.w() * 0.5f + 0.5f) * height;
+
+            osg::Vec2 lo, hi;
+            _layer->extent(id, lo, hi);
+            Candidate c;
+            c.id = int(id);
+            c.priority = id < _priorities.size() ? _priorities[id] : 0;
+            c.depth = clip.w();
+            c.x0 = sx + lo.x() * em - _margin;
+            c.y0 = sy + lo.y() * em - _margin;
+            c.x1 = sx + hi.x() * em + _margin;
+            c.y1 = sy + hi.y() * em + _margin;
+
+            if (c.x1 < 0.0f || c.y1 < 0.0f || c.x0 > width || c.y0 > height)
+            {
+                _layer->setVisible(id, false);
+                continue;
+            }
+            if (!_enabled)
+            {
+                _layer->setVisible(id, true);
+                continue;
+            }
+            _candidates.push_back(c);
+        }
+
+        // --- Place: priority order, overlap test through the grid ---
+        std::sort(_candidates.begin(), _candidates.end(), [](const Candidate &a, const Candidate &b)
+                  { return a.priority != b.priority ? a.priority > b.priority : a.depth < b.depth; });
+
+        _cols = std::max(1, int(std::ceil(width / _cellPixels)));
+        _rows = std::max(1, int(std::ceil(height / _cellPixels)));
+        if (_cells.size() < size_t(_cols * _rows))
+            _cells.resize(_cols * _rows);
+        for (int i = 0; i < _cols * _rows; ++i)
+            _cells[i].clear();
+        _placed.clear();
+
+        for (const Candidate &c : _candidates)
+        {
+            const bool fits = !overlapsPlaced(c);
+            _layer->setVisible(c.id, fits);
+            if (fits)
+                place(c);
+        }
+
+        _numVisible = 0;
+        for (unsigned int id = 0; id < n; ++id)
+            _numVisible += _layer->isVisible(id) ? 1 : 0;
+        _layer->applyVisibility();
+    }
+
+    void cellRange(const Candidate &c, int &cx0, int &cy0, int &cx1, int &cy1) const
+    {
+        cx0 = std::max(0, int(c.x0 / _cellPixels));
+        cy0 = std::max(0, int(c.y0 / _cellPixels));
+        cx1 = std::min(_cols - 1, int(c.x1 / _cellPixels));
+        cy1 = std::min(_rows - 1, int(c.y1 / _cellPixels));
+    }
+
+    bool overlapsPlaced(const Candidate &c) const
+    {
+        int cx0, cy0, cx1, cy1;
+        cellRange(c, cx0, cy0, cx1, cy1);
+        for (int y = cy0; y <= cy1; ++y)
+        {
+            for (int x = cx0; x <= cx1; ++x)
+            {
+                for (int p : _cells[y * _cols + x])
+                {
+                    const Candidate &o = _placed[p];
+                    if (c.x0 < o.x1 && o.x0 < c.x1 && c.y0 < o.y1 && o.y0 < c.y1)
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void place(const Candidate &c)
+    {
+        const int index = int(_placed.size());
+        _placed.push_back(c);
+        int cx0, cy0, cx1, cy1;
+        cellRange(c, cx0, cy0, cx1, cy1);
+        for (int y = cy0; y <= cy1; ++y)
+            for (int x = cx0; x <= cx1; ++x)
+                _cells[y * _cols + x].push_back(index);
+    }
+
+    osg::observer_ptr<LabelLayer> _layer;
+    float _cellPixels;
+    float _margin;
+    bool _enabled = true;
+    unsigned int _numVisible = 0;
+    std::vector<int> _priorities;
+
+    std::vector<Candidate> _candidates;
+    std::vector<Candidate> _placed;
+    std::vector<std::vector<int>> _cells;
+    int _cols = 1, _rows = 1;
+};
@@ -0,0 +1,449 @@
+#pragma once
+#include <osg/BlendFunc>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Program>
+#include <osg/Texture2D>
+#include <osg/Uniform>
+#include <osgGA/GUIEventHandler>
+#include <osgText/Font>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//
+// LabelLayer
+// ----------
+// All entity annotations in one Geometry / one draw call.
+//
+// * Glyphs 32..126 are rasterised once into a private atlas texture.
+// * Every label owns a fixed range of maxChars quad slots, allocated up
+//   front; text is formatted into a fixed buffer (no std::string, no
+//   ostringstream) and only slots whose character or pen position changed
+//   are rewritten.
+// * Quads carry their anchor as the vertex and their glyph corner (in em
+//   units) as texcoord 1; the vertex shader billboards them in clip space,
+//   so moving a label touches 4 vertices per slot and resizing all labels
+//   is one uniform write - no glyph rebuild.
+// * Sizing is done entirely in the shader: the em is labelSize world
+//   units, projected to pixels at the anchor's depth and clamped to
+//   [min, max] pixels. setScreenSize(px) pins it to a constant pixel
+//   height, the SCREEN_COORDS equivalent. The viewport size uniform is
+//   updated by ViewportHandler only when the window size changes.
+// * Only labels flagged visible are in the index buffer; hiding a label
+//   (e.g. by LabelDeclutter) removes its triangles from the draw call.
+//
+class LabelLayer : public osg::Geode
+{
+public:
+    LabelLayer(const std::string &fontFile, unsigned int maxLabels = 64,
+               unsigned int maxChars = 64, unsigned int resolution = 32)
+        : _maxLabels(maxLabels), _maxChars(maxChars), _buffer(maxChars + 1, '\0')
+    {
+        buildAtlas(fontFile, resolution);
+        buildGeometry();
+        buildState();
+    }
+
+    // Returns the label id, or -1 when all labels are in use
+    int addLabel(const osg::Vec3 &anchor, const osg::Vec4 &color)
+    {
+        if (_numLabels >= _maxLabels)
+            return -1;
+        const int id = static_cast<int>(_numLabels++);
+        const unsigned int first = id * _maxChars * 4;
+        std::fill(_colors->begin() + first, _colors->begin() + first + _maxChars * 4, color);
+        _colors->dirty();
+        setAnchor(id, anchor);
+        _visible[id] = true;
+        _indicesDirty = true;
+        applyVisibility();
+        return id;
+    }
+
+    void setAnchor(int id, const osg::Vec3 &anchor)
+    {
+        const unsigned int first = id * _maxChars * 4;
+        if ((*_anchors)[first] == anchor)
+            return;
+        std::fill(_anchors->begin() + first, _anchors->begin() + first + _maxChars * 4, anchor);
+        _anchors->dirty();
+        _geom->dirtyBound();
+    }
+
+    // Lays out text and rewrites only the slots that changed
+    void setText(int id, const char *text)
+    {
+        const float lineHeight = 1.2f;
+        float penX = 0.0f, penY = 0.0f;
+        unsigned int slot = 0;
+        bool changed = false;
+        osg::Vec2 &extentMin = _extents[id * 2];
+        osg::Vec2 &extentMax = _extents[id * 2 + 1];
+        extentMin.set(0.0f, 0.0f);
+        extentMax.set(0.0f, 0.0f);
+
+        for (const char *c = text; *c && slot < _maxChars; ++c)
+        {
+            if (*c == '\n')
+            {
+                penX = 0.0f;
+                penY -= lineHeight;
+                continue;
+            }
+            const unsigned char ch = (*c >= 32 && *c < 127) ? *c : '?';
+            changed |= writeSlot(id, slot++, ch, penX, penY);
+            if (ch > 32)
+            {
+                const GlyphInfo &g = _glyphs[ch];
+                const osg::Vec2 pen(penX, penY);
+                const osg::Vec2 lo = pen + g.cornerMin, hi = pen + g.cornerMax;
+                extentMin.set(std::min(extentMin.x(), lo.x()), std::min(extentMin.y(), lo.y()));
+                extentMax.set(std::max(extentMax.x(), hi.x()), std::max(extentMax.y(), hi.y()));
+            }
+            penX += _glyphs[ch].advance;
+        }
+        // Collapse slots left over from a longer previous text
+        for (; slot < _maxChars; ++slot)
+            changed |= writeSlot(id, slot, 0, 0.0f, 0.0f);
+
+        if (changed)
+        {
+            _uvs->dirty();
+            _corners->dirty();
+        }
+    }
+
+    // printf-style setText through the layer's fixed buffer
+    void format(int id, const char *fmt, ...)
+    {
+        va_list args;
+        va_start(args, fmt);
+        std::vsnprintf(_buffer.data(), _buffer.size(), fmt, args);
+        va_end(args);
+        setText(id, _buffer.data());
+    }
+
+    // World units per em for every label
+    void setCharacterSize(float size) { _sizeUniform->set(size); }
+
+    // Clamp of the projected em height, in pixels
+    void setPixelSizeRange(float minPixels, float maxPixels)
+    {
+        _pixelRangeUniform->set(osg::Vec2(minPixels, maxPixels));
+    }
+
+    // Constant on-screen em height regardless of distance
+    void setScreenSize(float pixels) { setPixelSizeRange(pixels, pixels); }
+
+    unsigned int numLabels() const { return _numLabels; }
+    const osg::Vec3 &anchor(int id) const { return (*_anchors)[id * _maxChars * 4]; }
+
+    // Bounding box of the label's glyphs in em units, relative to the anchor
+    void extent(int id, osg::Vec2 &min, osg::Vec2 &max) const
+    {
+        min = _extents[id * 2];
+        max = _extents[id * 2 + 1];
+    }
+
+    float characterSize() const
+    {
+        float size = 0.0f;
+        _sizeUniform->get(size);
+        return size;
+    }
+
+    osg::Vec2 pixelSizeRange() const
+    {
+        osg::Vec2 range;
+        _pixelRangeUniform->get(range);
+        return range;
+    }
+
+    // Visibility is batched: flag labels, then applyVisibility() once
+    bool isVisible(int id) const { return _visible[id]; }
+    void setVisible(int id, bool visible)
+    {
+        if (_visible[id] == visible)
+            return;
+        _visible[id] = visible;
+        _indicesDirty = true;
+    }
+
+    // Rebuilds the index buffer from the visible labels, if any flag changed
+    void applyVisibility()
+    {
+        if (!_indicesDirty)
+            return;
+        _indicesDirty = false;
+
+        _quads->clear();
+        for (unsigned int id = 0; id < _numLabels; ++id)
+        {
+            if (!_visible[id])
+                continue;
+            for (unsigned int i = id * _maxChars; i < (id + 1) * _maxChars; ++i)
+            {
+                const unsigned int v = i * 4;
+                _quads->push_back(v + 0);
+                _quads->push_back(v + 1);
+                _quads->push_back(v + 2);
+                _quads->push_back(v + 0);
+                _quads->push_back(v + 2);
+                _quads->push_back(v + 3);
+            }
+        }
+        _quads->dirty();
+    }
+
+    // Keeps the viewportSize uniform in sync with the window
+    class ViewportHandler : public osgGA::GUIEventHandler
+    {
+    public:
+        explicit ViewportHandler(LabelLayer *layer) : _layer(layer) {}
+
+        bool handle(const osgGA::GUIEventAdapter &ea, osgGA::GUIActionAdapter &) override
+        {
+            if (ea.getEventType() != osgGA::GUIEventAdapter::RESIZE &&
+                ea.getEventType() != osgGA::GUIEventAdapter::FRAME)
+                return false;
+
+            const osg::Vec2 size(float(ea.getWindowWidth()), float(ea.getWindowHeight()));
+            if (_layer.valid() && size != _size && size.x() > 0.0f && size.y() > 0.0f)
+            {
+                _size = size;
+                _layer->_viewportUniform->set(size);
+            }
+            return false;
+        }
+
+    private:
+        osg::observer_ptr<LabelLayer> _layer;
+        osg::Vec2 _size;
+    };
+
+private:
+    struct GlyphInfo
+    {
+        osg::Vec2 uvMin, uvMax;         // atlas rectangle
+        osg::Vec2 cornerMin, cornerMax; // quad in em units relative to the pen
+        float advance = 0.0f;
+    };
+
+    struct Slot
+    {
+        unsigned char ch = 0;
+        float x = 0.0f, y = 0.0f;
+    };
+
+    // Returns true when the slot had to be rewritten
+    bool writeSlot(int id, unsigned int index, unsigned char ch, float x, float y)
+    {
+        Slot &s = _slots[id * _maxChars + index];
+        if (s.ch == ch && s.x == x && s.y == y)
+            return false;
+        s.ch = ch;
+        s.x = x;
+        s.y = y;
+
+        const GlyphInfo &g = _glyphs[ch];
+        const unsigned int v = (id * _maxChars + index) * 4;
+        const osg::Vec2 pen(x, y);
+        const bool visible = ch > 32;
+        (*_corners)[v + 0] = visible ? pen + g.cornerMin : pen;
+        (*_corners)[v + 1] = visible ? pen + osg::Vec2(g.cornerMax.x(), g.cornerMin.y()) : pen;
+        (*_corners)[v + 2] = visible ? pen + g.cornerMax : pen;
+        (*_corners)[v + 3] = visible ? pen + osg::Vec2(g.cornerMin.x(), g.cornerMax.y()) : pen;
+        (*_uvs)[v + 0] = g.uvMin;
+        (*_uvs)[v + 1] = osg::Vec2(g.uvMax.x(), g.uvMin.y());
+        (*_uvs)[v + 2] = g.uvMax;
+        (*_uvs)[v + 3] = osg::Vec2(g.uvMin.x(), g.uvMax.y());
+        return true;
+    }
+
+    static unsigned char coverage(const osg::Image *img, int x, int y)
+    {
+        const unsigned char *p = img->data(x, y);
+        switch (img->getPixelFormat())
+        {
+        case GL_LUMINANCE_ALPHA:
+            return p[1];
+        case GL_RGBA:
+            return p[3];
+        default: // GL_ALPHA / GL_RED / GL_LUMINANCE
+            return p[0];
+        }
+    }
+
+    void buildAtlas(const std::string &fontFile, unsigned int res)
+    {
+        osg::ref_ptr<osgText::Font> font = osgText::readRefFontFile(fontFile);
+        if (!font)
+            font = osgText::Font::getDefaultFont();
+
+        const int cols = 16, rows = 6; // 96 glyphs, 32..127
+        const int cell = static_cast<int>(res) + 2;
+        osg::ref_ptr<osg::Image> atlas = new osg::Image;
+        atlas->allocateImage(cols * cell, rows * cell, 1, GL_ALPHA, GL_UNSIGNED_BYTE);
+        std::memset(atlas->data(), 0, atlas->getTotalSizeInBytes());
+
+        const float W = float(atlas->s()), H = float(atlas->t());
+        for (unsigned int ch = 32; ch < 127; ++ch)
+        {
+            osgText::Glyph *glyph = font->getGlyph(osgText::FontResolution(res, res), ch);
+            if (!glyph)
+                continue;
+
+            const int ox = int((ch - 32) % cols) * cell + 1;
+            const int oy = int((ch - 32) / cols) * cell + 1;
+            const int gw = std::min(glyph->s(), cell - 2);
+            const int gh = std::min(glyph->t(), cell - 2);
+            if (glyph->data())
+            {
+                for (int y = 0; y < gh; ++y)
+                    for (int x = 0; x < gw; ++x)
+                        *atlas->data(ox + x, oy + y) = coverage(glyph, x, y);
+            }
+
+            // Bearing and advance are normalised to the em by osgText
+            GlyphInfo &g = _glyphs[ch];
+            g.uvMin.set(ox / W, oy / H);
+            g.uvMax.set((ox + gw) / W, (oy + gh) / H);
+            g.cornerMin = glyph->getHorizontalBearing();
+            g.cornerMax = g.cornerMin + osg::Vec2(float(gw) / res, float(gh) / res);
+            g.advance = glyph->getHorizontalAdvance();
+        }
+
+        _atlas = new osg::Texture2D(atlas.get());
+        _atlas->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+        _atlas->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        _atlas->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        _atlas->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+        _atlas->setResizeNonPowerOfTwoHint(false);
+    }
+
+    void buildGeometry()
+    {
+        const unsigned int numSlots = _maxLabels * _maxChars;
+        _slots.resize(numSlots);
+
+        _anchors = new osg::Vec3Array(numSlots * 4);
+        _corners = new osg::Vec2Array(numSlots * 4);
+        _uvs = new osg::Vec2Array(numSlots * 4);
+        _colors = new osg::Vec4Array(numSlots * 4);
+        _extents.resize(_maxLabels * 2);
+        _visible.resize(_maxLabels, false);
+
+        // Filled by applyVisibility(); reserved so it never reallocates
+        _quads = new osg::DrawElementsUInt(GL_TRIANGLES);
+        _quads->reserve(numSlots * 6);
+
+        _geom = new osg::Geometry;
+        _geom->setUseDisplayList(false);
+        _geom->setUseVertexBufferObjects(true);
+        _geom->setDataVariance(osg::Object::DYNAMIC);
+        _geom->setVertexArray(_anchors.get());
+        _geom->setColorArray(_colors.get(), osg::Array::BIND_PER_VERTEX);
+        _geom->setTexCoordArray(0, _uvs.get(), osg::Array::BIND_PER_VERTEX);
+        _geom->setTexCoordArray(1, _corners.get(), osg::Array::BIND_PER_VERTEX);
+        _geom->addPrimitiveSet(_quads.get());
+        _geom->setComputeBoundingBoxCallback(new LabelBoundsCallback(this));
+        addDrawable(_geom.get());
+    }
+
+    void buildState()
+    {
+        static const char *vertSrc =
+            "#version 120\n"
+            "uniform float labelSize;\n"      // world units per em
+            "uniform vec2 labelPixelRange;\n" // em clamp in pixels
+            "uniform vec2 viewportSize;\n"
+            "void main()\n"
+            "{\n"
+            "    vec4 clip = gl_ProjectionMatrix * (gl_ModelViewMatrix * gl_Vertex);\n"
+            "    float w = max(abs(clip.w), 1e-6);\n"
+            "    float pixelsPerUnit = gl_ProjectionMatrix[1][1] * 0.5 * viewportSize.y / w;\n"
+            "    float em = clamp(labelSize * pixelsPerUnit, labelPixelRange.x, labelPixelRange.y);\n"
+            "    clip.xy += gl_MultiTexCoord1.xy * em * 2.0 / viewportSize * clip.w;\n"
+            "    gl_Position = clip;\n"
+            "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+            "    gl_FrontColor = gl_Color;\n"
+            "}\n";
+        static const char *fragSrc =
+            "#version 120\n"
+            "uniform sampler2D glyphAtlas;\n"
+            "void main()\n"
+            "{\n"
+            "    float a = texture2D(glyphAtlas, gl_TexCoord[0].st).a;\n"
+            "    gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * a);\n"
+            "}\n";
+
+        osg::ref_ptr<osg::Program> program = new osg::Program;
+        program->addShader(new osg::Shader(osg::Shader::VERTEX, vertSrc));
+        program->addShader(new osg::Shader(osg::Shader::FRAGMENT, fragSrc));
+
+        _sizeUniform = new osg::Uniform("labelSize", 10.0f);
+        _pixelRangeUniform = new osg::Uniform("labelPixelRange", osg::Vec2(0.0f, 1.0e6f));
+        _viewportUniform = new osg::Uniform("viewportSize", osg::Vec2(1280.0f, 720.0f));
+
+        osg::StateSet *ss = getOrCreateStateSet();
+        ss->setAttributeAndModes(program.get(), osg::StateAttribute::ON);
+        ss->setTextureAttributeAndModes(0, _atlas.get(), osg::StateAttribute::ON);
+        ss->addUniform(new osg::Uniform("glyphAtlas", 0));
+        ss->addUniform(_sizeUniform.get());
+        ss->addUniform(_pixelRangeUniform.get());
+        ss->addUniform(_viewportUniform.get());
+        ss->setAttributeAndModes(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), osg::StateAttribute::ON);
+        ss->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        ss->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+    }
+
+    // Anchors grown by a label extent so culling stays conservative. With
+    // pixel-sized labels the world extent is unbounded; small culling
+    // errors at the screen edge are accepted rather than disabling culling.
+    struct LabelBoundsCallback : public osg::Drawable::ComputeBoundingBoxCallback
+    {
+        explicit LabelBoundsCallback(LabelLayer *layer) : _layer(layer) {}
+
+        osg::BoundingBox computeBound(const osg::Drawable &) const override
+        {
+            osg::BoundingBox bb;
+            float size = 10.0f;
+            _layer->_sizeUniform->get(size);
+            const float extent = size * float(_layer->_maxChars);
+            for (unsigned int i = 0; i < _layer->_numLabels; ++i)
+            {
+                const osg::Vec3 &a = (*_layer->_anchors)[i * _layer->_maxChars * 4];
+                bb.expandBy(a - osg::Vec3(extent, extent, extent));
+                bb.expandBy(a + osg::Vec3(extent, extent, extent));
+            }
+            return bb;
+        }
+
+        LabelLayer *_layer;
+    };
+
+    unsigned int _maxLabels;
+    unsigned int _maxChars;
+    unsigned int _numLabels = 0;
+    std::vector<char> _buffer;
+    std::vector<Slot> _slots;
+    std::vector<osg::Vec2> _extents; // min/max em box per label
+    std::vector<bool> _visible;
+    bool _indicesDirty = false;
+    GlyphInfo _glyphs[128];
+
+    osg::ref_ptr<osg::Geometry> _geom;
+    osg::ref_ptr<osg::Vec3Array> _anchors;
+    osg::ref_ptr<osg::Vec2Array> _corners;
+    osg::ref_ptr<osg::Vec2Array> _uvs;
+    osg::ref_ptr<osg::Vec4Array> _colors;
+    osg::ref_ptr<osg::DrawElementsUInt> _quads;
+    osg::ref_ptr<osg::Texture2D> _atlas;
+    osg::ref_ptr<osg::Uniform> _sizeUniform;
+    osg::ref_ptr<osg::Uniform> _pixelRangeUniform;
+    osg::ref_ptr<osg::Uniform> _viewportUniform;
+};
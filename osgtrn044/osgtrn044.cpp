@@ -1,79 +1,65 @@
 #include <osg/Group>
 #include <osg/Geode>
-#include <osgText/Text>
 #include <osg/PositionAttitudeTransform>
 #include <osgViewer/Viewer>
 #include <osgDB/ReadFile>
-#include <osg/Timer>
 #include <osgViewer/Viewer>
 #include <cmath>
 
-// ========================= Text Size Update Callback =========================
-class TextScaleCallback : public osg::NodeCallback
-{
-public:
-    TextScaleCallback(osgText::Text* text) : _text(text) {}
-
-    void operator()(osg::Node* node, osg::NodeVisitor* nv) override
-    {
-        if (!_text) return;
-
-        // Get eye (camera) position
-        osg::Vec3d eye = nv->getEyePoint();
-
-        // Get text world position (center of bounding box)
-        osg::Vec3d textPos = _text->getBound().center();
-
-        // Compute distance
-        double distance = (eye - textPos).length();
-
-        // Adjust font size with distance
-        float baseSize = 10.0f;
-        float scaleFactor = 0.03f; // smaller value = less scaling
-        float newSize = baseSize + distance * scaleFactor;
-
-        _text->setCharacterSize(newSize);
-
-        traverse(node, nv);
-    }
-
-private:
-    osg::observer_ptr<osgText::Text> _text;
-};
+#include "LabelDeclutter.hpp"
+#include "LabelLayer.hpp"
 
 // ========================= Cessna Circular Motion =========================
 class CessnaUpdateCallback : public osg::NodeCallback
 {
 public:
-    CessnaUpdateCallback() : _startTime(osg::Timer::instance()->time_s()) {}
+    CessnaUpdateCallback(float radius = 100.0f, float angularSpeed = 0.5f, float height = 30.0f,
+                         float phase = 0.0f)
+        : _radius(radius), _angularSpeed(angularSpeed), _height(height), _phase(phase) {}
+
+    // Keeps a label anchored at a point in the aircraft frame
+    void setLabel(LabelLayer* layer, int id, const osg::Vec3& offset)
+    {
+        _labels = layer;
+        _labelId = id;
+        _labelOffset = offset;
+    }
 
     void operator()(osg::Node* node, osg::NodeVisitor* nv) override
     {
         osg::PositionAttitudeTransform* pat = dynamic_cast<osg::PositionAttitudeTransform*>(node);
         if (!pat) return;
 
-        double t = osg::Timer::instance()->time_s() - _startTime;
-
-        float radius = 100.0f;
-        float angularSpeed = 0.5f;
-        float height = 30.0f;
+        // Frame-stamp time, so viewer.frame(t) can replay a run exactly
+        double t = nv->getFrameStamp()->getSimulationTime();
 
-        float x = radius * std::cos(angularSpeed * t);
-        float y = radius * std::sin(angularSpeed * t);
-        float z = height;
+        float angle = _angularSpeed * t + _phase;
+        float x = _radius * std::cos(angle);
+        float y = _radius * std::sin(angle);
+        float z = _height;
 
-        float yaw = angularSpeed * t + osg::PI_2;
+        float yaw = angle + osg::PI_2;
         osg::Quat rotation;
         rotation.makeRotate(yaw, osg::Vec3(0, 0, 1));
 
         pat->setPosition(osg::Vec3(x, y, z));
         pat->setAttitude(rotation);
 
+        if (_labels.valid())
+            _labels->setAnchor(_labelId, osg::Vec3(x, y, z) + rotation * _labelOffset);
+
         traverse(node, nv);
     }
 
 private:
-    double _startTime;
+    float _radius;
+    float _angularSpeed;
+    float _height;
+    float _phase;
+
+    osg::observer_ptr<LabelLayer> _labels;
+    int _labelId = -1;
+    osg::Vec3 _labelOffset;
 };
 
 // ========================= Main =========================
@@ -94,35 +80,56 @@ int main(int argc, char** argv)
         return 1;
     }
 
+    // --- Labels ---
+    // Constant pixel size is computed in the label shader; no per-frame CPU work.
+    // One layer for every aircraft, anchored in world space by the motion callbacks.
+    const int numTraffic = 40;
+    osg::ref_ptr<LabelLayer> labels = new LabelLayer("fonts/arial.ttf", numTraffic + 1, 32);
+    labels->setCharacterSize(10.0f);
+    labels->setScreenSize(18.0f);
+    viewer.addEventHandler(new LabelLayer::ViewportHandler(labels));
+
+    // Overlapping labels are hidden in priority order ('d' toggles)
+    osg::ref_ptr<LabelDeclutter> declutter = new LabelDeclutter(labels.get());
+    labels->setCullCallback(declutter);
+    viewer.addEventHandler(new LabelDeclutter::ToggleHandler(declutter));
+
     // --- Cessna transform ---
     osg::ref_ptr<osg::PositionAttitudeTransform> cessnaXform = new osg::PositionAttitudeTransform();
     cessnaXform->addChild(cessna);
 
-    // --- Text ---
-    osg::ref_ptr<osgText::Text> text = new osgText::Text();
-    text->setFont("fonts/arial.ttf");
-    text->setCharacterSize(10.0f);
-    text->setAxisAlignment(osgText::TextBase::SCREEN);
-    text->setColor(osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f));
-    text->setText("Right Wing Label");
+    int wingLabel = labels->addLabel(osg::Vec3(), osg::Vec4(1.0f, 1.0f, 0.0f, 1.0f));
+    labels->setText(wingLabel, "Right Wing Label");
+    declutter->setPriority(wingLabel, 1);
 
-    osg::ref_ptr<osg::Geode> textGeode = new osg::Geode();
-    textGeode->addDrawable(text);
+    // Motion callback; label offset: right wing + above
+    osg::ref_ptr<CessnaUpdateCallback> cessnaMotion = new CessnaUpdateCallback();
+    cessnaMotion->setLabel(labels.get(), wingLabel, osg::Vec3(0.0f, 15.0f, 5.0f));
+    cessnaXform->setUpdateCallback(cessnaMotion);
 
-    osg::ref_ptr<osg::PositionAttitudeTransform> textOffset = new osg::PositionAttitudeTransform();
-    textOffset->setPosition(osg::Vec3(0.0f, 15.0f, 5.0f)); // offset: right wing + above
-    textOffset->addChild(textGeode);
+    root->addChild(cessnaXform);
 
-    // Font scaling callback
-    textGeode->setUpdateCallback(new TextScaleCallback(text));
+    // --- Traffic: shared model, one label each ---
+    for (int i = 0; i < numTraffic; ++i)
+    {
+        const float radius = 140.0f + 12.0f * (i % 8);
+        const float height = 10.0f + 6.0f * (i % 5);
+        const float speed = 0.2f + 0.03f * (i % 7);
+        const float phase = float(i) * 2.0f * osg::PI / numTraffic;
 
-    // Add to plane
-    cessnaXform->addChild(textOffset);
+        osg::ref_ptr<osg::PositionAttitudeTransform> xform = new osg::PositionAttitudeTransform();
+        xform->addChild(cessna);
 
-    // Motion callback
-    cessnaXform->setUpdateCallback(new CessnaUpdateCallback());
+        int id = labels->addLabel(osg::Vec3(), osg::Vec4(0.6f, 0.9f, 1.0f, 1.0f));
+        labels->format(id, "TRF%02d\nALT %dm", i, int(height));
 
-    root->addChild(cessnaXform);
+        osg::ref_ptr<CessnaUpdateCallback> motion = new CessnaUpdateCallback(radius, speed, height, phase);
+        motion->setLabel(labels.get(), id, osg::Vec3(0.0f, 0.0f, 8.0f));
+        xform->setUpdateCallback(motion);
+        root->addChild(xform);
+    }
+
+    root->addChild(labels);
     viewer.setSceneData(root);
     viewer.setUpViewInWindow(100, 100, 600, 600);
 
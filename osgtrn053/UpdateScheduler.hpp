@@ -0,0 +1,173 @@
+#pragma once
+#include <osg/NodeCallback>
+#include <osg/NodeVisitor>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ======================= Pose Thread Pool ===========================
+// Persistent workers for fork/join loops inside one update traversal.
+// The calling thread takes part in the work, so a pool with zero workers
+// simply runs everything serially.
+class PoseThreadPool
+{
+public:
+    explicit PoseThreadPool(unsigned int workers = defaultWorkers())
+    {
+        for (unsigned int i = 0; i < workers; ++i)
+            _threads.emplace_back([this] { workerLoop(); });
+    }
+
+    ~PoseThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _quit = true;
+        }
+        _wake.notify_all();
+        for (std::thread &t : _threads)
+            t.join();
+    }
+
+    size_t numWorkers() const { return _threads.size(); }
+
+    static unsigned int defaultWorkers()
+    {
+        const unsigned int hw = std::thread::hardware_concurrency();
+        return hw > 1 ? hw - 1 : 0;
+    }
+
+    // Calls fn(begin, end) over [0, count) in chunks of grain; returns when all chunks are done
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn)
+    {
+        grain = std::max<size_t>(grain, 1);
+        if (_threads.empty() || count <= grain)
+        {
+            fn(0, count);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _fn = &fn;
+            _count = count;
+            _grain = grain;
+            _next = 0;
+            _active = _threads.size();
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        runChunks();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this] { return _active == 0; });
+        _fn = nullptr;
+    }
+
+private:
+    void runChunks()
+    {
+        for (;;)
+        {
+            const size_t begin = _next.fetch_add(_grain);
+            if (begin >= _count)
+                break;
+            (*_fn)(begin, std::min(begin + _grain, _count));
+        }
+    }
+
+    void workerLoop()
+    {
+        unsigned long long seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&] { return _quit || _generation != seen; });
+                if (_quit)
+                    return;
+                seen = _generation;
+            }
+
+            runChunks();
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_active == 0)
+                _done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+
+    const std::function<void(size_t, size_t)> *_fn = nullptr;
+    size_t _count = 0;
+    size_t _grain = 1;
+    std::atomic<size_t> _next{0};
+    size_t _active = 0;
+    unsigned long long _generation = 0;
+    bool _quit = false;
+};
+
+// ======================= Pose Job ===========================
+// One entity's per-frame work, split in three phases:
+//   prepare()  - runs serially first; copies any shared, mutable state
+//                (UI settings, globals) the job needs into its members
+//   compute(t) - runs on any pool thread; may only read t/immutable data
+//                and write the job's own members
+//   commit()   - runs serially afterwards; applies the result to the
+//                scene graph (MatrixTransform, trails, ...)
+class PoseJob : public osg::Referenced
+{
+public:
+    virtual void prepare() {}
+    virtual void compute(float t) = 0;
+    virtual void commit() = 0;
+};
+
+// ======================= Update Scheduler ===========================
+// Root update callback replacing per-entity NodeCallbacks:
+//   1. serial:   clock() advances the shared sim time, prepare() per job
+//   2. parallel: compute(t) for every registered job
+//   3. serial:   commit() for every job, then the normal traversal
+class UpdateScheduler : public osg::NodeCallback
+{
+public:
+    explicit UpdateScheduler(std::function<float()> clock, size_t grain = 16,
+                             unsigned int workers = PoseThreadPool::defaultWorkers())
+        : _clock(std::move(clock)), _grain(grain), _pool(workers) {}
+
+    void addJob(PoseJob *job) { _jobs.push_back(job); }
+    size_t numJobs() const { return _jobs.size(); }
+    size_t numWorkers() const { return _pool.numWorkers(); }
+
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        const float t = _clock();
+        for (auto &job : _jobs)
+            job->prepare();
+
+        _pool.parallelFor(_jobs.size(), _grain, [&](size_t begin, size_t end)
+                          {
+            for (size_t i = begin; i < end; ++i)
+                _jobs[i]->compute(t); });
+
+        for (auto &job : _jobs)
+            job->commit();
+
+        traverse(node, nv);
+    }
+
+private:
+    std::function<float()> _clock;
+    size_t _grain;
+    PoseThreadPool _pool;
+    std::vector<osg::ref_ptr<PoseJob>> _jobs;
+};
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
 #include <osgViewer/Viewer>
 #include <osgViewer/config/SingleWindow>
 #include <osg/MatrixTransform>
@@ -20,6 +21,8 @@
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "UpdateScheduler.hpp"
+#include "CommandQueue.hpp"
 
 // ======================= ANSI Color Codes ===========================
 #define ANSI_RESET "\e[0;0m]"
@@ -48,16 +51,19 @@ public:
 };
 
 // ======================= Global Animation State ===========================
+// Written only in the serial update phases, by the clock and by commands
+// posted from the panel; atomic so drawUi() can read it on the draw thread.
+// Pose jobs copy what they need in prepare().
 struct AnimationState
 {
-    bool running = false;
-    bool logging = false;
-    float t = 0.0f;
-    float speed = 0.25f;
-    bool isFighter = true;
+    std::atomic<bool> running{false};
+    std::atomic<bool> logging{false};
+    std::atomic<float> t{0.0f};
+    std::atomic<float> speed{0.25f};
+    std::atomic<bool> isFighter{true};
 } gAnim;
 
-float gTailOffset = -14.0f;
+std::atomic<float> gTailOffset{-14.0f};
 const osg::Vec3 WORLD_UP(0, 0, -1);
 
 // ======================= Basis Adjustments ===========================
@@ -212,31 +218,47 @@ private:
     osg::Vec3 _last;
 };
 
-// ======================= F-14 Motion Callback ===========================
-class F14MotionCallback : public osg::NodeCallback
+// ======================= Sim Clock ===========================
+// Serial phase of the update scheduler: advances gAnim.t, after the
+// commands posted from the panel have run
+float advanceSimTime()
+{
+    if (gAnim.running)
+    {
+        float t = gAnim.t + gAnim.speed * 0.01f;
+        if (t >= 1.0f)
+        {
+            t = 1.0f;
+            gAnim.running = false;
+        }
+        gAnim.t = t;
+    }
+    return gAnim.t;
+}
+
+// ======================= F-14 Pose Job ===========================
+class F14PoseJob : public PoseJob
 {
 public:
-    F14MotionCallback(osg::MatrixTransform *m, Trail *trail, float tailOffset = 4.0f)
+    F14PoseJob(osg::MatrixTransform *m, Trail *trail, float tailOffset = 4.0f)
         : mt(m), _trail(trail), _tailOffset(tailOffset) {}
 
-    void operator()(osg::Node *, osg::NodeVisitor *nv) override
+    // Serial phase: snapshot the settings compute() uses
+    void prepare() override
     {
-        if (gAnim.running)
-        {
-            gAnim.t += gAnim.speed * 0.01f;
-            if (gAnim.t >= 1.0f)
-            {
-                gAnim.t = 1.0f;
-                gAnim.running = false;
-            }
-        }
+        _isFighter = gAnim.isFighter;
+        _tail = gTailOffset;
+    }
 
+    // Parallel phase: reads only t, constants and the snapshot, writes only this job
+    void compute(float t) override
+    {
         const float dt = 0.02f;
-        float t0 = std::max(0.0f, gAnim.t - dt);
-        float t2 = std::min(1.0f, gAnim.t + dt);
+        float t0 = std::max(0.0f, t - dt);
+        float t2 = std::min(1.0f, t + dt);
 
         osg::Vec3 p0 = aircraftTrajectory(t0);
-        osg::Vec3 p1 = aircraftTrajectory(gAnim.t);
+        osg::Vec3 p1 = aircraftTrajectory(t);
         osg::Vec3 p2 = aircraftTrajectory(t2);
 
         osg::Vec3 fwd = p2 - p1;
@@ -244,41 +266,50 @@ public:
             fwd = p1 - p0;
         fwd.normalize();
 
-        osg::Quat orient = orientationFromTangent(fwd, WORLD_UP, gAnim.isFighter);
+        osg::Quat orient = orientationFromTangent(fwd, WORLD_UP, _isFighter);
         osg::Quat finalRot = orient * F14_BASIS;
-        mt->setMatrix(osg::Matrix::rotate(finalRot) * osg::Matrix::translate(p1));
+        _matrix = osg::Matrix::rotate(finalRot) * osg::Matrix::translate(p1);
 
-        if (_trail.valid())
-        {
-            osg::Vec3 worldForward = finalRot * osg::Vec3(1, 0, 0);
-            osg::Vec3 tailPoint = p1 - worldForward * gTailOffset;
-            _trail->addPoint(tailPoint);
-        }
+        osg::Vec3 worldForward = finalRot * osg::Vec3(1, 0, 0);
+        _tailPoint = p1 - worldForward * _tail;
+    }
 
-        traverse(mt.get(), nv);
+    // Serial phase: apply the result to the scene graph
+    void commit() override
+    {
+        mt->setMatrix(_matrix);
+        if (_trail.valid())
+            _trail->addPoint(_tailPoint);
     }
 
 private:
     osg::ref_ptr<osg::MatrixTransform> mt;
     osg::observer_ptr<Trail> _trail;
     float _tailOffset;
+
+    bool _isFighter = true;
+    float _tail = 0.0f;
+    osg::Matrix _matrix;
+    osg::Vec3 _tailPoint;
 };
 
-// ======================= Missile Motion Callback ===========================
-class MissileMotionCallback : public osg::NodeCallback
+// ======================= Missile Pose Job ===========================
+class MissilePoseJob : public PoseJob
 {
 public:
-    MissileMotionCallback(osg::MatrixTransform *m, Trail *trail)
+    MissilePoseJob(osg::MatrixTransform *m, Trail *trail)
         : mt(m), _trail(trail) {}
 
-    void operator()(osg::Node *, osg::NodeVisitor *nv) override
+    void prepare() override { _isFighter = gAnim.isFighter; }
+
+    void compute(float t) override
     {
         const float dt = 0.02f;
-        float t0 = std::max(0.0f, gAnim.t - dt);
-        float t2 = std::min(1.0f, gAnim.t + dt);
+        float t0 = std::max(0.0f, t - dt);
+        float t2 = std::min(1.0f, t + dt);
 
         osg::Vec3 p0 = missileTrajectory(t0);
-        osg::Vec3 p1 = missileTrajectory(gAnim.t);
+        osg::Vec3 p1 = missileTrajectory(t);
         osg::Vec3 p2 = missileTrajectory(t2);
 
         osg::Vec3 fwd = p2 - p1;
@@ -286,30 +317,36 @@ public:
             fwd = p1 - p0;
         fwd.normalize();
 
-        osg::Quat orient = orientationFromTangent(fwd, WORLD_UP, !gAnim.isFighter);
+        osg::Quat orient = orientationFromTangent(fwd, WORLD_UP, !_isFighter);
         osg::Quat finalRot = orient * MISSILE_BASIS;
-        mt->setMatrix(osg::Matrix::rotate(finalRot) * osg::Matrix::translate(p1));
+        _matrix = osg::Matrix::rotate(finalRot) * osg::Matrix::translate(p1);
+        _tailPoint = p1 - fwd * 5.0f;
+    }
 
+    void commit() override
+    {
+        mt->setMatrix(_matrix);
         if (_trail.valid())
-        {
-            osg::Vec3 tail = p1 - fwd * 5.0f;
-            _trail->addPoint(tail);
-        }
-
-        traverse(mt.get(), nv);
+            _trail->addPoint(_tailPoint);
     }
 
 private:
     osg::ref_ptr<osg::MatrixTransform> mt;
     osg::observer_ptr<Trail> _trail;
+
+    bool _isFighter = true;
+    osg::Matrix _matrix;
+    osg::Vec3 _tailPoint;
 };
 
 // ======================= ImGui Control ===========================
+// Runs on the draw thread: every action is posted to the CommandQueue and
+// happens in the next update traversal, before the scheduler runs.
 class ImGuiControl : public OsgImGuiHandler
 {
 public:
-    ImGuiControl(Trail *trail1, Trail *trail2)
-        : _trail1(trail1), _trail2(trail2) {}
+    ImGuiControl(CommandQueue *commands, Trail *trail1, Trail *trail2)
+        : _commands(commands), _trail1(trail1), _trail2(trail2) {}
 
 protected:
     void drawUi() override
@@ -317,28 +354,38 @@ protected:
         ImGui::Begin("Motion Controller");
 
         if (ImGui::Button(gAnim.running ? "Stop" : "Start"))
-            gAnim.running = !gAnim.running;
+            _commands->post([]() { gAnim.running = !gAnim.running; });
 
         ImGui::SameLine();
         if (ImGui::Button("Reset"))
         {
-            gAnim.t = 0.0f;
-            gAnim.running = false;
-            if (_trail1.valid())
-                _trail1->clear();
-            if (_trail2.valid())
-                _trail2->clear();
-            std::cout << ANSI_CYAN << "=== Reset motion & trails ===" << ANSI_RESET << std::endl;
+            _commands->post([this]()
+            {
+                gAnim.t = 0.0f;
+                gAnim.running = false;
+                if (_trail1.valid())
+                    _trail1->clear();
+                if (_trail2.valid())
+                    _trail2->clear();
+                std::cout << ANSI_CYAN << "=== Reset motion & trails ===" << ANSI_RESET << std::endl;
+            });
         }
 
-        ImGui::SliderFloat("Speed", &gAnim.speed, 0.05f, 1.0f, "%.2f");
-        ImGui::SliderFloat("t (timeline)", &gAnim.t, 0.0f, 1.0f, "%.3f");
-        ImGui::SliderFloat("Tail Offset", &gTailOffset, -60.0f, 0.0f, "%.1f");
+        float speed = gAnim.speed;
+        if (ImGui::SliderFloat("Speed", &speed, 0.05f, 1.0f, "%.2f"))
+            _commands->post([speed]() { gAnim.speed = speed; });
+        float t = gAnim.t;
+        if (ImGui::SliderFloat("t (timeline)", &t, 0.0f, 1.0f, "%.3f"))
+            _commands->post([t]() { gAnim.t = t; });
+        float tailOffset = gTailOffset;
+        if (ImGui::SliderFloat("Tail Offset", &tailOffset, -60.0f, 0.0f, "%.1f"))
+            _commands->post([tailOffset]() { gTailOffset = tailOffset; });
 
         ImGui::End();
     }
 
 private:
+    osg::ref_ptr<CommandQueue> _commands;
     osg::observer_ptr<Trail> _trail1;
     osg::observer_ptr<Trail> _trail2;
 };
@@ -369,7 +416,6 @@ int main(int, char **)
     osg::ref_ptr<osg::MatrixTransform> aircraft = new osg::MatrixTransform;
     aircraft->setMatrix(osg::Matrix::rotate(F14_BASIS));
     aircraft->addChild(f14);
-    aircraft->addUpdateCallback(new F14MotionCallback(aircraft, trailF14.get(), -24.0f));
     root->addChild(aircraft);
 
     // --- Missile trail ---
@@ -396,9 +442,18 @@ int main(int, char **)
     osg::ref_ptr<osg::Node> missileModel = osgDB::readRefNodeFile(dataPath + "AIM-9L.ac");
     osg::ref_ptr<osg::MatrixTransform> missile = new osg::MatrixTransform;
     missile->addChild(missileModel);
-    missile->addUpdateCallback(new MissileMotionCallback(missile.get(), trailMissile.get()));
     root->addChild(missile);
 
+    // UI actions; added first so they run ahead of the scheduler
+    osg::ref_ptr<CommandQueue> commands = new CommandQueue;
+    root->addUpdateCallback(commands);
+
+    // Entity poses: computed in parallel, committed serially, once per update traversal
+    osg::ref_ptr<UpdateScheduler> scheduler = new UpdateScheduler(advanceSimTime);
+    scheduler->addJob(new F14PoseJob(aircraft, trailF14.get(), -24.0f));
+    scheduler->addJob(new MissilePoseJob(missile.get(), trailMissile.get()));
+    root->addUpdateCallback(scheduler);
+
     osg::ref_ptr<osgGA::NodeTrackerManipulator> nodeTracker = new osgGA::NodeTrackerManipulator;
     nodeTracker->setTrackerMode(osgGA::NodeTrackerManipulator::NODE_CENTER);
     nodeTracker->setRotationMode(osgGA::NodeTrackerManipulator::TRACKBALL);
@@ -416,7 +471,7 @@ int main(int, char **)
     viewer.apply(new osgViewer::SingleWindow(100, 100, 1000, 700));
     viewer.setSceneData(root);
     viewer.setRealizeOperation(new ImGuiInitOperation);
-    viewer.addEventHandler(new ImGuiControl(trailF14.get(), trailMissile.get()));
+    viewer.addEventHandler(new ImGuiControl(commands.get(), trailF14.get(), trailMissile.get()));
 
     return viewer.run();
 }
\ No newline at end of file
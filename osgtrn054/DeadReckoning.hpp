@@ -0,0 +1,214 @@
+#pragma once
+#include <osg/Vec3>
+#include <osg/Vec3d>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+//
+// DeadReckoning
+// -------------
+// Extrapolates sparse entity states to every render frame.
+//
+// Each entity holds its last authoritative state (sender time, position,
+// velocity and, for the constant-acceleration model, the acceleration
+// implied by the last two velocities). update() predicts all entities at
+// one local time in a single branch-free pass over structure-of-arrays
+// data; the model is a 0/1 factor on the acceleration term rather than a
+// branch. The loop vectorizes with -O3 -fno-trapping-math.
+//
+// Latency: predictions are made for the sender's "now", so transit delay
+// is extrapolated away instead of showing as lag. With sharedClock the
+// sender stamps states with this host's steady clock and the mapping is
+// exact; otherwise the clock offset is the smallest (received - sent)
+// seen, which removes jitter but not the base delay.
+//
+// Corrections converge instead of popping: when a new state arrives, the
+// gap between what was on screen and the new prediction is kept as an
+// offset and faded out over convergeTime. Gaps beyond snapDistance
+// (teleports, respawns) are applied at once. Extrapolation stops after
+// maxExtrapolation seconds without news, so a lost entity freezes rather
+// than flying off.
+//
+// The matching sender rule, needsUpdate(), only transmits when the
+// receiver's prediction is off by more than a threshold (or a heartbeat
+// expired); with a threshold below what is visible, the feed rate drops
+// without stutter. The sender must run the receiver's model, with the
+// acceleration impliedAcceleration() gives for its last two sent states.
+//
+class DeadReckoning
+{
+public:
+    enum Model
+    {
+        ConstantVelocity,
+        ConstantAcceleration
+    };
+
+    struct Settings
+    {
+        Model model = ConstantAcceleration;
+        double convergeTime = 0.25;    // seconds to fade out a correction
+        double snapDistance = 50.0;    // metres; larger corrections jump
+        double maxExtrapolation = 1.0; // seconds past the last state
+        bool sharedClock = false;      // sender times are LiveFeed::now()
+    };
+
+    Settings &settings() { return _settings; }
+    const Settings &settings() const { return _settings; }
+
+    size_t size() const { return _t.size(); }
+
+    // Adds an entity with no state yet; returns its index
+    size_t add()
+    {
+        for (std::vector<double> *v : {&_t, &_tc, &_px, &_py, &_pz, &_vx, &_vy, &_vz, &_ax, &_ay, &_az,
+                                       &_ex, &_ey, &_ez, &_outX, &_outY, &_outZ})
+            v->push_back(0.0);
+        for (std::vector<float> *v : {&_headX, &_headY, &_headZ})
+            v->push_back(0.0f);
+        _valid.push_back(false);
+        return _t.size() - 1;
+    }
+
+    // Sender time of the last state applied to entity i
+    double stateTime(size_t i) const { return _t[i]; }
+
+    // Applies an authoritative state sent at sender time t and received at
+    // local time receivedAt
+    void correct(size_t i, double t, const osg::Vec3d &p, const osg::Vec3 &v, double receivedAt)
+    {
+        if (_settings.sharedClock)
+            _clockOffset = 0.0;
+        else
+            _clockOffset = _hasClock ? std::min(_clockOffset, receivedAt - t) : receivedAt - t;
+        _hasClock = true;
+
+        // Where the entity is drawn at this moment, before the correction
+        osg::Vec3d shown = p;
+        if (_valid[i])
+            shown = predict(i, receivedAt);
+
+        osg::Vec3 a;
+        if (_valid[i])
+            a = impliedAcceleration(_t[i], osg::Vec3(_vx[i], _vy[i], _vz[i]), t, v);
+        _ax[i] = a.x();
+        _ay[i] = a.y();
+        _az[i] = a.z();
+
+        _t[i] = t;
+        _px[i] = p.x();
+        _py[i] = p.y();
+        _pz[i] = p.z();
+        _vx[i] = v.x();
+        _vy[i] = v.y();
+        _vz[i] = v.z();
+        _ex[i] = _ey[i] = _ez[i] = 0.0;
+        _tc[i] = receivedAt;
+
+        osg::Vec3d error = shown - predict(i, receivedAt);
+        if (_valid[i] && error.length() <= _settings.snapDistance)
+        {
+            _ex[i] = error.x();
+            _ey[i] = error.y();
+            _ez[i] = error.z();
+        }
+        _valid[i] = true;
+    }
+
+    // Predicts every entity at local time now
+    void update(double now)
+    {
+        extrapolate(_t.size(), now, now - _clockOffset,
+                    _settings.model == ConstantAcceleration ? 1.0 : 0.0, _settings.maxExtrapolation,
+                    1.0 / std::max(_settings.convergeTime, 1e-6), _t.data(), _tc.data(),
+                    _px.data(), _py.data(), _pz.data(), _vx.data(), _vy.data(), _vz.data(),
+                    _ax.data(), _ay.data(), _az.data(), _ex.data(), _ey.data(), _ez.data(),
+                    _outX.data(), _outY.data(), _outZ.data(), _headX.data(), _headY.data(), _headZ.data());
+    }
+
+    // Results of the last update()
+    osg::Vec3d position(size_t i) const { return osg::Vec3d(_outX[i], _outY[i], _outZ[i]); }
+    const float *headingX() const { return _headX.data(); }
+    const float *headingY() const { return _headY.data(); }
+    const float *headingZ() const { return _headZ.data(); }
+
+    // Acceleration the constant-acceleration model derives from two
+    // consecutive states (zero unless time moved forward)
+    static osg::Vec3 impliedAcceleration(double tPrev, const osg::Vec3 &vPrev, double t, const osg::Vec3 &v)
+    {
+        return t > tPrev ? (v - vPrev) / float(t - tPrev) : osg::Vec3();
+    }
+
+    // Sender-side rule: true when a receiver extrapolating the last sent
+    // state (tSent, pSent, vSent, aSent) with `model` would be more than
+    // threshold metres off at time t, or heartbeat seconds have passed
+    static bool needsUpdate(Model model, double t, const osg::Vec3d &p, double tSent, const osg::Vec3d &pSent,
+                            const osg::Vec3 &vSent, const osg::Vec3 &aSent, double threshold, double heartbeat)
+    {
+        const double dt = t - tSent;
+        const double ha = model == ConstantAcceleration ? 0.5 * dt * dt : 0.0;
+        const osg::Vec3d predicted = pSent + osg::Vec3d(vSent) * dt + osg::Vec3d(aSent) * ha;
+        return dt >= heartbeat || (p - predicted).length() > threshold;
+    }
+
+private:
+    // The vectorized loop. Outputs are __restrict parameters: GCC ignores
+    // __restrict on local pointers and would give up on alias checks.
+    static void extrapolate(size_t n, double now, double senderNow, double accel, double maxDt, double invConverge,
+                            const double *t, const double *tc,
+                            const double *px, const double *py, const double *pz,
+                            const double *vx, const double *vy, const double *vz,
+                            const double *ax, const double *ay, const double *az,
+                            const double *ex, const double *ey, const double *ez,
+                            double *__restrict outX, double *__restrict outY, double *__restrict outZ,
+                            float *__restrict headX, float *__restrict headY, float *__restrict headZ)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            // Clamped by value; std::min/max return references, which GCC
+            // does not always turn into vector selects
+            double dt = senderNow - t[i];
+            dt = dt < 0.0 ? 0.0 : dt;
+            dt = dt > maxDt ? maxDt : dt;
+            const double ha = 0.5 * accel * dt * dt;
+            // Remaining share of the correction, eased out
+            double a = (now - tc[i]) * invConverge;
+            a = a > 1.0 ? 1.0 : a;
+            const double k = 1.0 - a * a * (3.0 - 2.0 * a);
+
+            outX[i] = px[i] + vx[i] * dt + ax[i] * ha + ex[i] * k;
+            outY[i] = py[i] + vy[i] * dt + ay[i] * ha + ey[i] * k;
+            outZ[i] = pz[i] + vz[i] * dt + az[i] * ha + ez[i] * k;
+            headX[i] = float(vx[i] + ax[i] * accel * dt);
+            headY[i] = float(vy[i] + ay[i] * accel * dt);
+            headZ[i] = float(vz[i] + az[i] * accel * dt);
+        }
+    }
+
+    // Same prediction as update(), for a single entity
+    osg::Vec3d predict(size_t i, double now) const
+    {
+        const double dt = std::min(std::max(now - _clockOffset - _t[i], 0.0), _settings.maxExtrapolation);
+        const double ha = _settings.model == ConstantAcceleration ? 0.5 * dt * dt : 0.0;
+        const double a = std::min((now - _tc[i]) / std::max(_settings.convergeTime, 1e-6), 1.0);
+        const double k = 1.0 - a * a * (3.0 - 2.0 * a);
+        return osg::Vec3d(_px[i] + _vx[i] * dt + _ax[i] * ha + _ex[i] * k,
+                          _py[i] + _vy[i] * dt + _ay[i] * ha + _ey[i] * k,
+                          _pz[i] + _vz[i] * dt + _az[i] * ha + _ez[i] * k);
+    }
+
+    Settings _settings;
+    double _clockOffset = 0.0; // local - sender time, smallest seen
+    bool _hasClock = false;
+
+    // Last authoritative state, one entry per entity
+    std::vector<double> _t, _tc; // sender time, local time of the correction
+    std::vector<double> _px, _py, _pz, _vx, _vy, _vz, _ax, _ay, _az;
+    std::vector<double> _ex, _ey, _ez; // correction being faded out
+    std::vector<bool> _valid;
+
+    // Output of update()
+    std::vector<double> _outX, _outY, _outZ;
+    std::vector<float> _headX, _headY, _headZ;
+};
@@ -0,0 +1,292 @@
+#pragma once
+#include <osg/NodeCallback>
+#include <osg/NodeVisitor>
+#include <osg/FrameStamp>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// InputRecorder
+// -------------
+// Deterministic record & replay of everything that feeds the simulation.
+//
+// UI panels never touch sim state directly; they push InputEvents. The
+// events are applied at the start of the next update traversal by
+// InputRecorder::Callback, which also tags them with that frame's index and
+// stores the frame's simulation time. Replaying feeds the same events at the
+// same frame indices and drives viewer.frame() with the recorded times, so
+// a run is reproduced bit for bit (given the same seed for rand()).
+//
+// The log itself is only touched in update(); the UI asks for a save with
+// requestSave() and reads the counters, which are atomic.
+//
+// Binary layout (native endianness):
+//   char[4]  magic "INPL"
+//   uint32   version
+//   uint32   seed
+//   uint32   frameCount, double simTime[frameCount]
+//   uint32   eventCount, { uint32 frame, uint32 type, float value }[eventCount]
+//
+struct InputEvent
+{
+    enum Type : uint32_t
+    {
+        SetRunning,
+        SetSpeed,
+        Seek,
+        Reset,
+        ClearTrails,
+        LoadTrails,
+        SetConstantSpeed
+    };
+    static constexpr uint32_t NumTypes = SetConstantSpeed + 1;
+
+    uint32_t frame;
+    Type type;
+    float value;
+};
+
+class InputRecorder : public osg::Referenced
+{
+public:
+    using ApplyFunc = std::function<void(const InputEvent &)>;
+
+    explicit InputRecorder(ApplyFunc apply) : _apply(std::move(apply)) {}
+
+    bool isReplaying() const { return _replaying; }
+    uint32_t seed() const { return _seed; }
+    uint32_t frame() const { return _frame; }
+    size_t numRecordedFrames() const { return _frameTimes.size(); }
+    size_t numEvents() const { return _eventCount; }
+
+    // Starts a fresh log; anything recorded or loaded before is dropped
+    void startRecording(uint32_t seed)
+    {
+        _seed = seed;
+        _events.clear();
+        _frameTimes.clear();
+        _frame = 0;
+        _eventCount = 0;
+        _replaying = false;
+    }
+
+    bool startReplay(const std::string &file)
+    {
+        if (!load(file))
+            return false;
+        _frame = 0;
+        _nextEvent = 0;
+        _replaying = true;
+        return true;
+    }
+
+    // True while recorded frame times remain to be fed to viewer.frame()
+    bool hasReplayFrame() const { return _replaying && _frame < _frameTimes.size(); }
+    double replayFrameTime() const { return _frameTimes[_frame]; }
+
+    // Called from UI code (draw thread); ignored while replaying
+    void push(InputEvent::Type type, float value = 0.0f)
+    {
+        if (_replaying)
+            return;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.push_back({0, type, value});
+    }
+
+    // Called from UI code; the log is written during the next update
+    void requestSave(const std::string &file)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _saveFile = file;
+    }
+
+    // Applies this frame's inputs; called once per update traversal
+    void update(double simTime)
+    {
+        if (_replaying)
+        {
+            while (_nextEvent < _events.size() && _events[_nextEvent].frame == _frame)
+                _apply(_events[_nextEvent++]);
+            if (_frame + 1 >= _frameTimes.size())
+                _replaying = false; // log exhausted, hand control back to the UI
+        }
+        else
+        {
+            std::vector<InputEvent> pending;
+            std::string saveFile;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                pending.swap(_pending);
+                saveFile.swap(_saveFile);
+            }
+            for (InputEvent &e : pending)
+            {
+                e.frame = _frame;
+                _events.push_back(e);
+                _apply(e);
+            }
+            _frameTimes.push_back(simTime);
+            _eventCount = _events.size();
+            if (!saveFile.empty())
+                save(saveFile);
+        }
+        ++_frame;
+    }
+
+    bool save(const std::string &file) const
+    {
+        std::ofstream out(file, std::ios::binary);
+        if (!out)
+        {
+            std::cerr << "Cannot open " << file << "\n";
+            return false;
+        }
+        const uint32_t version = 1;
+        const uint32_t frameCount = static_cast<uint32_t>(_frameTimes.size());
+        const uint32_t eventCount = static_cast<uint32_t>(_events.size());
+        out.write("INPL", 4);
+        writePod(out, version);
+        writePod(out, _seed);
+        writePod(out, frameCount);
+        out.write(reinterpret_cast<const char *>(_frameTimes.data()), frameCount * sizeof(double));
+        writePod(out, eventCount);
+        for (const InputEvent &e : _events)
+        {
+            writePod(out, e.frame);
+            writePod(out, static_cast<uint32_t>(e.type));
+            writePod(out, e.value);
+        }
+        std::cout << "Input log written: " << file << " (" << frameCount << " frames, "
+                  << eventCount << " events)\n";
+        return bool(out);
+    }
+
+    // ======================= Update Callback ===========================
+    // Install on the scene root so inputs land before any entity callback
+    class Callback : public osg::NodeCallback
+    {
+    public:
+        explicit Callback(InputRecorder *recorder) : _recorder(recorder) {}
+
+        void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+        {
+            const osg::FrameStamp *fs = nv->getFrameStamp();
+            _recorder->update(fs ? fs->getSimulationTime() : 0.0);
+            traverse(node, nv);
+        }
+
+    private:
+        osg::ref_ptr<InputRecorder> _recorder;
+    };
+
+private:
+    template <typename T>
+    static void writePod(std::ostream &out, const T &v)
+    {
+        out.write(reinterpret_cast<const char *>(&v), sizeof(T));
+    }
+
+    template <typename T>
+    static void readPod(std::istream &in, T &v)
+    {
+        in.read(reinterpret_cast<char *>(&v), sizeof(T));
+    }
+
+    // Bytes between the read position and the end, or -1 if unknown
+    static std::streamoff remaining(std::istream &in)
+    {
+        const std::streampos here = in.tellg();
+        if (here < 0)
+            return -1;
+        in.seekg(0, std::ios::end);
+        const std::streamoff left = in.tellg() - here;
+        in.seekg(here);
+        return in ? left : -1;
+    }
+
+    // Parses into locals; the recorder only changes once the whole log is valid
+    bool load(const std::string &file)
+    {
+        std::ifstream in(file, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "Cannot open " << file << "\n";
+            return false;
+        }
+        char magic[4];
+        uint32_t version = 0, seed = 0, frameCount = 0, eventCount = 0;
+        in.read(magic, 4);
+        readPod(in, version);
+        readPod(in, seed);
+        readPod(in, frameCount);
+        if (!in || std::string(magic, 4) != "INPL" || version != 1)
+        {
+            std::cerr << "Invalid input log " << file << "\n";
+            return false;
+        }
+
+        // Counts are checked against the file size before allocating
+        const uint64_t eventSize = 2 * sizeof(uint32_t) + sizeof(float);
+        std::streamoff left = remaining(in);
+        if (left < 0 || uint64_t(frameCount) * sizeof(double) + sizeof(uint32_t) > uint64_t(left))
+        {
+            std::cerr << "Truncated input log " << file << "\n";
+            return false;
+        }
+        std::vector<double> frameTimes(frameCount);
+        in.read(reinterpret_cast<char *>(frameTimes.data()), frameCount * sizeof(double));
+        readPod(in, eventCount);
+        left = remaining(in);
+        if (!in || left < 0 || uint64_t(eventCount) * eventSize > uint64_t(left))
+        {
+            std::cerr << "Truncated input log " << file << "\n";
+            return false;
+        }
+
+        // Replay matches events to frames in order: frames must not go back
+        // or pass the end of the log, and every type must be known
+        std::vector<InputEvent> events(eventCount);
+        uint32_t lastFrame = 0;
+        for (InputEvent &e : events)
+        {
+            uint32_t type = 0;
+            readPod(in, e.frame);
+            readPod(in, type);
+            readPod(in, e.value);
+            if (!in || e.frame < lastFrame || e.frame >= frameCount || type >= InputEvent::NumTypes)
+            {
+                std::cerr << "Invalid event in input log " << file << "\n";
+                return false;
+            }
+            e.type = static_cast<InputEvent::Type>(type);
+            lastFrame = e.frame;
+        }
+
+        _seed = seed;
+        _frameTimes.swap(frameTimes);
+        _events.swap(events);
+        _eventCount = _events.size();
+        std::cout << "Input log loaded: " << file << " (" << frameCount << " frames, "
+                  << eventCount << " events)\n";
+        return true;
+    }
+
+    ApplyFunc _apply;
+    std::mutex _mutex;
+    std::vector<InputEvent> _pending;
+    std::string _saveFile;
+
+    std::vector<InputEvent> _events;
+    std::vector<double> _frameTimes;
+    size_t _nextEvent = 0;
+    std::atomic<size_t> _eventCount{0};
+    std::atomic<uint32_t> _frame{0};
+    uint32_t _seed = 0;
+    std::atomic<bool> _replaying{false};
+};
@@ -0,0 +1,189 @@
+#pragma once
+#include <osg/Referenced>
+#include <osg/Vec3>
+#include <osg/Vec3d>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+//
+// LiveFeed
+// --------
+// Entity states pushed by an external simulation over local UDP.
+//
+// A receiver thread blocks on the socket and appends every decoded state
+// to an incoming list under a mutex. poll() runs in the update traversal
+// and only swaps that list out, so the render thread never waits on the
+// network. It then folds the states into the entity table: unknown ids
+// spawn a new entry (callers spawn nodes for entities()[oldSize..]), and
+// a state older than the one already held is dropped (UDP may reorder).
+//
+// The table only holds the latest state; DeadReckoning turns it into a
+// smooth per-frame position.
+//
+// Datagram layout (native endianness, local use only):
+//   char[4]      magic "LFD1"
+//   uint32       count (at most MAX_STATES)
+//   EntityState  states[count]
+//
+struct EntityState
+{
+    uint32_t id;
+    uint32_t kind;        // 0 fighter, 1 missile
+    double time;          // sender sim time, seconds
+    double position[3];   // NED metres
+    float velocity[3];    // NED m/s
+};
+static_assert(std::is_trivially_copyable<EntityState>::value, "EntityState is copied as raw bytes");
+
+class LiveFeed : public osg::Referenced
+{
+public:
+    static constexpr uint16_t DEFAULT_PORT = 5054;
+    static constexpr size_t MAX_STATES = 24; // keeps a datagram under 1400 bytes
+
+    struct Entity
+    {
+        uint32_t id;
+        uint32_t kind;
+        double time;       // sender time of the last state
+        double receivedAt; // local now() when it arrived
+        osg::Vec3d position;
+        osg::Vec3 velocity;
+    };
+
+    ~LiveFeed() { close(); }
+
+    bool open(uint16_t port = DEFAULT_PORT)
+    {
+        close();
+        _socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (_socket < 0)
+        {
+            std::cerr << "LiveFeed: cannot create socket\n";
+            return false;
+        }
+
+        // Room for a few frames of hundreds of entities at 100 Hz
+        int bufferSize = 4 << 20;
+        setsockopt(_socket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        // Wake up regularly so close() can stop the thread
+        timeval timeout{0, 100000};
+        setsockopt(_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(_socket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+        {
+            std::cerr << "LiveFeed: cannot bind UDP port " << port << "\n";
+            ::close(_socket);
+            _socket = -1;
+            return false;
+        }
+
+        _running = true;
+        _thread = std::thread(&LiveFeed::receive, this);
+        std::cout << "LiveFeed listening on 127.0.0.1:" << port << "\n";
+        return true;
+    }
+
+    void close()
+    {
+        _running = false;
+        if (_thread.joinable())
+            _thread.join();
+        if (_socket >= 0)
+            ::close(_socket);
+        _socket = -1;
+    }
+
+    bool isOpen() const { return _socket >= 0; }
+
+    // Applies everything received since the last call; returns the number
+    // of states applied. Call from the update traversal.
+    size_t poll()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.swap(_incoming);
+        }
+        const double receivedAt = now();
+        for (const EntityState &s : _pending)
+        {
+            auto found = _index.find(s.id);
+            if (found == _index.end())
+            {
+                found = _index.emplace(s.id, _entities.size()).first;
+                _entities.push_back(Entity{s.id, s.kind, s.time, receivedAt, osg::Vec3d(), osg::Vec3()});
+            }
+            else if (s.time < _entities[found->second].time)
+                continue;
+
+            Entity &e = _entities[found->second];
+            e.time = s.time;
+            e.receivedAt = receivedAt;
+            e.position.set(s.position[0], s.position[1], s.position[2]);
+            e.velocity.set(s.velocity[0], s.velocity[1], s.velocity[2]);
+        }
+        const size_t applied = _pending.size();
+        _pending.clear();
+        return applied;
+    }
+
+    // Entities in order of first appearance; indices never change
+    const std::vector<Entity> &entities() const { return _entities; }
+
+    static double now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static constexpr const char MAGIC[4] = {'L', 'F', 'D', '1'};
+
+private:
+    void receive()
+    {
+        std::vector<char> buffer(8 + MAX_STATES * sizeof(EntityState));
+        while (_running)
+        {
+            const ssize_t n = ::recv(_socket, buffer.data(), buffer.size(), 0);
+            if (n < 8 || std::memcmp(buffer.data(), MAGIC, 4) != 0)
+                continue; // timeout or foreign datagram
+
+            uint32_t count;
+            std::memcpy(&count, buffer.data() + 4, sizeof(count));
+            if (count > MAX_STATES || size_t(n) < 8 + count * sizeof(EntityState))
+                continue;
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            const size_t first = _incoming.size();
+            _incoming.resize(first + count);
+            std::memcpy(&_incoming[first], buffer.data() + 8, count * sizeof(EntityState));
+        }
+    }
+
+    int _socket = -1;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+
+    std::mutex _mutex;
+    std::vector<EntityState> _incoming; // filled by the receiver thread
+    std::vector<EntityState> _pending;  // being applied by poll()
+
+    std::vector<Entity> _entities;
+    std::unordered_map<uint32_t, size_t> _index;
+};
@@ -0,0 +1,154 @@
+#pragma once
+#include "LiveFeed.hpp"
+#include "DeadReckoning.hpp"
+#include <algorithm>
+#include <cmath>
+
+//
+// LiveFeedGenerator
+// -----------------
+// Stand-in for an external simulation: a thread that sends `count`
+// entities flying circles around `center` to a LiveFeed port at `rate`
+// Hz, MAX_STATES states per datagram. Even ids are fighters, odd ids
+// missiles; each entity has its own radius, altitude, speed and phase.
+//
+// States are stamped with LiveFeed::now() (DeadReckoning sharedClock).
+// With setThresholds(), an entity is only sent when a receiver's dead
+// reckoning of its last sent state would be off by more than `threshold`
+// metres, or after `heartbeat` seconds. `model` must be the receiver's
+// DeadReckoning model for that bound to hold.
+//
+class LiveFeedGenerator
+{
+public:
+    ~LiveFeedGenerator() { stop(); }
+
+    bool start(uint16_t port, size_t count, const osg::Vec3d &center, double rate = 100.0)
+    {
+        stop();
+        _socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (_socket < 0)
+        {
+            std::cerr << "LiveFeedGenerator: cannot create socket\n";
+            return false;
+        }
+        _target = sockaddr_in{};
+        _target.sin_family = AF_INET;
+        _target.sin_port = htons(port);
+        _target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        _count = count;
+        _center = center;
+        _period = 1.0 / rate;
+
+        _running = true;
+        _thread = std::thread(&LiveFeedGenerator::run, this);
+        std::cout << "LiveFeedGenerator: " << count << " entities at " << rate << " Hz\n";
+        return true;
+    }
+
+    // threshold 0 sends every entity every tick
+    void setThresholds(double threshold, DeadReckoning::Model model, double heartbeat = 1.0)
+    {
+        _threshold = threshold;
+        _model = model;
+        _heartbeat = heartbeat;
+    }
+
+    void stop()
+    {
+        _running = false;
+        if (_thread.joinable())
+            _thread.join();
+        if (_socket >= 0)
+            ::close(_socket);
+        _socket = -1;
+    }
+
+private:
+    // t: seconds since start; the state is stamped with `stamp`
+    EntityState state(uint32_t id, double t, double stamp) const
+    {
+        const double radius = 200.0 + 37.0 * (id % 16);
+        const double altitude = 50.0 + 20.0 * (id % 7);
+        const double omega = (id % 2 ? 0.35 : 0.2) * (id % 3 ? 1.0 : -1.0);
+        const double angle = omega * t + id * 0.61;
+
+        EntityState s;
+        s.id = id;
+        s.kind = id % 2;
+        s.time = stamp;
+        s.position[0] = _center.x() + radius * std::cos(angle);
+        s.position[1] = _center.y() + radius * std::sin(angle);
+        s.position[2] = _center.z() - altitude - 10.0 * std::sin(0.5 * t + id);
+        s.velocity[0] = float(-radius * omega * std::sin(angle));
+        s.velocity[1] = float(radius * omega * std::cos(angle));
+        s.velocity[2] = float(-5.0 * std::cos(0.5 * t + id));
+        return s;
+    }
+
+    void run()
+    {
+        std::vector<char> buffer(8 + LiveFeed::MAX_STATES * sizeof(EntityState));
+        std::memcpy(buffer.data(), LiveFeed::MAGIC, 4);
+        std::vector<EntityState> sent(_count);
+        std::vector<osg::Vec3> sentAccel(_count);
+        std::vector<bool> hasSent(_count, false);
+        uint32_t n = 0;
+        auto flush = [&]()
+        {
+            if (n == 0)
+                return;
+            std::memcpy(buffer.data() + 4, &n, sizeof(n));
+            ::sendto(_socket, buffer.data(), 8 + n * sizeof(EntityState), 0,
+                     reinterpret_cast<const sockaddr *>(&_target), sizeof(_target));
+            n = 0;
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        auto next = start;
+        while (_running)
+        {
+            const double stamp = LiveFeed::now();
+            const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            for (size_t id = 0; id < _count; ++id)
+            {
+                const EntityState s = state(uint32_t(id), t, stamp);
+                const osg::Vec3 v(s.velocity[0], s.velocity[1], s.velocity[2]);
+                if (hasSent[id])
+                {
+                    const EntityState &last = sent[id];
+                    const osg::Vec3 lastV(last.velocity[0], last.velocity[1], last.velocity[2]);
+                    if (_threshold > 0.0)
+                    {
+                        const osg::Vec3d p(s.position[0], s.position[1], s.position[2]);
+                        const osg::Vec3d lastP(last.position[0], last.position[1], last.position[2]);
+                        if (!DeadReckoning::needsUpdate(_model, stamp, p, last.time, lastP, lastV, sentAccel[id],
+                                                        _threshold, _heartbeat))
+                            continue;
+                    }
+                    // What the receiver will derive once this state arrives
+                    sentAccel[id] = DeadReckoning::impliedAcceleration(last.time, lastV, s.time, v);
+                }
+                sent[id] = s;
+                hasSent[id] = true;
+                std::memcpy(buffer.data() + 8 + n * sizeof(EntityState), &s, sizeof(s));
+                if (++n == LiveFeed::MAX_STATES)
+                    flush();
+            }
+            flush();
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(_period));
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    int _socket = -1;
+    sockaddr_in _target{};
+    size_t _count = 0;
+    osg::Vec3d _center;
+    double _period = 0.01;
+    double _threshold = 0.0;
+    double _heartbeat = 1.0;
+    DeadReckoning::Model _model = DeadReckoning::ConstantAcceleration;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <osg/Camera>
+#include <osg/NodeCallback>
+#include <osg/NodeVisitor>
+#include <osg/Vec3d>
+#include <cmath>
+#include <iostream>
+
+//
+// RenderOrigin
+// ------------
+// Floating origin for large worlds. Simulation state stays in double
+// precision world coordinates (NED metres); everything handed to the
+// renderer is expressed relative to origin(), which is kept near the
+// camera so float vertex data and GPU transforms stay small.
+//
+// The origin only moves when the camera drifts more than rebaseDistance
+// from it, and it snaps to a grid of that size so the value is exactly
+// representable. Each move bumps generation(); consumers that cache
+// render-space data (e.g. trail transforms) compare it to know when to
+// re-place themselves. Vertices are never rewritten on a rebase.
+//
+class RenderOrigin : public osg::Referenced
+{
+public:
+    explicit RenderOrigin(double rebaseDistance = 1000.0) : _rebaseDistance(rebaseDistance) {}
+
+    const osg::Vec3d &origin() const { return _origin; }
+    unsigned int generation() const { return _generation; }
+
+    osg::Vec3d toRender(const osg::Vec3d &world) const { return world - _origin; }
+    osg::Vec3d toWorld(const osg::Vec3d &render) const { return render + _origin; }
+
+    // Jumps straight to a position, e.g. the start of a trajectory
+    void reset(const osg::Vec3d &world)
+    {
+        _origin = snap(world);
+        ++_generation;
+    }
+
+    // Rebases when the focus point drifted too far; returns true on a move
+    bool update(const osg::Vec3d &world)
+    {
+        if ((world - _origin).length() <= _rebaseDistance)
+            return false;
+        _origin = snap(world);
+        ++_generation;
+        std::cout << "Render origin rebased to " << _origin.x() << " " << _origin.y() << " " << _origin.z() << "\n";
+        return true;
+    }
+
+    // ======================= Update Callback ===========================
+    // Install on the scene root: rebases around the eye of the last frame
+    // before any entity converts its position to render space
+    class Callback : public osg::NodeCallback
+    {
+    public:
+        Callback(RenderOrigin *origin, osg::Camera *camera) : _origin(origin), _camera(camera) {}
+
+        void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+        {
+            if (_camera.valid())
+                _origin->update(_origin->toWorld(_camera->getInverseViewMatrix().getTrans()));
+            traverse(node, nv);
+        }
+
+    private:
+        osg::ref_ptr<RenderOrigin> _origin;
+        osg::observer_ptr<osg::Camera> _camera;
+    };
+
+private:
+    osg::Vec3d snap(const osg::Vec3d &p) const
+    {
+        return osg::Vec3d(std::floor(p.x() / _rebaseDistance + 0.5) * _rebaseDistance,
+                          std::floor(p.y() / _rebaseDistance + 0.5) * _rebaseDistance,
+                          std::floor(p.z() / _rebaseDistance + 0.5) * _rebaseDistance);
+    }
+
+    double _rebaseDistance;
+    osg::Vec3d _origin;
+    unsigned int _generation = 0;
+};
@@ -0,0 +1,268 @@
+#pragma once
+#include <osg/Quat>
+#include <osg/Vec3d>
+#include <osg/Vec4>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//
+// ScenarioFile
+// ------------
+// Declarative description of a run: models, trajectory sources, entities
+// with their trails, and the camera. Text, one directive per line, '#'
+// starts a comment:
+//
+//   reserve    <models> <tracks> <entities>          (optional, pre-sizes)
+//   datapath   <dir>                                 (prefix for model files)
+//   model      <name> <file> <f14|missile> <qx qy qz qw>
+//   track      <name> <file>
+//   entity     <name> <model> <track> <set> [trail <maxPoints> <minSegment> <tail> <r g b a>]
+//   camera     <entity> <eye n e d> <center n e d> <up n e d>
+//
+// model: the display frame the model is built in and its basis rotation.
+// track: a text file of "t x y z [x y z ...]" lines; set k of an entity
+// picks the k-th xyz triple. entity: tail is how far behind the entity,
+// along its path, the trail is drawn. camera: the tracker follows
+// <entity>; vectors are NED.
+//
+// The file is read line by line; names must be defined before use, so
+// the loader resolves references to indices as it goes. Each name may be
+// defined once per kind, and reserve counts above MAX_RESERVE are
+// rejected rather than allocated.
+//
+struct ScenarioModel
+{
+    enum Display
+    {
+        F14,
+        Missile
+    };
+
+    std::string name;
+    std::string file;
+    Display display = F14;
+    osg::Quat basis;
+};
+
+struct ScenarioTrack
+{
+    std::string name;
+    std::string file;
+};
+
+struct ScenarioEntity
+{
+    std::string name;
+    size_t model = 0;
+    size_t track = 0;
+    size_t set = 0;
+    bool trail = false;
+    size_t trailPoints = 2000;
+    float trailSegment = 0.15f;
+    float trailTail = 0.0f;
+    osg::Vec4 trailColor = osg::Vec4(1.0f, 1.0f, 0.2f, 1.0f);
+};
+
+struct ScenarioCamera
+{
+    size_t entity = 0;
+    osg::Vec3d eye = osg::Vec3d(-100, 0, -25);
+    osg::Vec3d center;
+    osg::Vec3d up = osg::Vec3d(0, 0, -1);
+};
+
+struct Scenario
+{
+    std::string dataPath;
+    std::vector<ScenarioModel> models;
+    std::vector<ScenarioTrack> tracks;
+    std::vector<ScenarioEntity> entities;
+    ScenarioCamera camera;
+};
+
+namespace scenario_detail
+{
+    const size_t MAX_RESERVE = 100000;
+
+    template <class T>
+    bool find(const std::vector<T> &items, const std::string &name, size_t &index)
+    {
+        for (index = 0; index < items.size(); ++index)
+        {
+            if (items[index].name == name)
+                return true;
+        }
+        return false;
+    }
+}
+
+inline bool loadScenario(const std::string &file, Scenario &out)
+{
+    std::ifstream in(file);
+    if (!in)
+    {
+        std::cerr << "Cannot open " << file << "\n";
+        return false;
+    }
+
+    Scenario s;
+    std::string line;
+    int lineNo = 0;
+    auto fail = [&](const std::string &what)
+    {
+        std::cerr << file << ":" << lineNo << ": " << what << "\n";
+        return false;
+    };
+
+    while (std::getline(in, line))
+    {
+        ++lineNo;
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+        std::istringstream ss(line);
+        std::string key;
+        if (!(ss >> key))
+            continue;
+
+        if (key == "reserve")
+        {
+            size_t models, tracks, entities;
+            if (!(ss >> models >> tracks >> entities))
+                return fail("reserve <models> <tracks> <entities>");
+            if (models > scenario_detail::MAX_RESERVE || tracks > scenario_detail::MAX_RESERVE ||
+                entities > scenario_detail::MAX_RESERVE)
+                return fail("reserve count above " + std::to_string(scenario_detail::MAX_RESERVE));
+            s.models.reserve(models);
+            s.tracks.reserve(tracks);
+            s.entities.reserve(entities);
+        }
+        else if (key == "datapath")
+        {
+            if (!(ss >> s.dataPath))
+                return fail("datapath <dir>");
+        }
+        else if (key == "model")
+        {
+            ScenarioModel m;
+            std::string display;
+            double x, y, z, w;
+            if (!(ss >> m.name >> m.file >> display >> x >> y >> z >> w))
+                return fail("model <name> <file> <f14|missile> <qx qy qz qw>");
+            if (display != "f14" && display != "missile")
+                return fail("unknown display frame " + display);
+            size_t existing;
+            if (scenario_detail::find(s.models, m.name, existing))
+                return fail("duplicate model " + m.name);
+            m.display = display == "f14" ? ScenarioModel::F14 : ScenarioModel::Missile;
+            m.basis.set(x, y, z, w);
+            s.models.push_back(m);
+        }
+        else if (key == "track")
+        {
+            ScenarioTrack t;
+            if (!(ss >> t.name >> t.file))
+                return fail("track <name> <file>");
+            size_t existing;
+            if (scenario_detail::find(s.tracks, t.name, existing))
+                return fail("duplicate track " + t.name);
+            s.tracks.push_back(t);
+        }
+        else if (key == "entity")
+        {
+            ScenarioEntity e;
+            std::string model, track;
+            if (!(ss >> e.name >> model >> track >> e.set))
+                return fail("entity <name> <model> <track> <set> [trail ...]");
+            size_t existing;
+            if (scenario_detail::find(s.entities, e.name, existing))
+                return fail("duplicate entity " + e.name);
+            if (!scenario_detail::find(s.models, model, e.model))
+                return fail("unknown model " + model);
+            if (!scenario_detail::find(s.tracks, track, e.track))
+                return fail("unknown track " + track);
+            std::string option;
+            if (ss >> option)
+            {
+                if (option != "trail")
+                    return fail("unknown entity option " + option);
+                float r, g, b, a;
+                if (!(ss >> e.trailPoints >> e.trailSegment >> e.trailTail >> r >> g >> b >> a))
+                    return fail("trail <maxPoints> <minSegment> <tail> <r g b a>");
+                e.trail = true;
+                e.trailColor.set(r, g, b, a);
+            }
+            s.entities.push_back(e);
+        }
+        else if (key == "camera")
+        {
+            std::string entity;
+            ScenarioCamera &c = s.camera;
+            if (!(ss >> entity >> c.eye.x() >> c.eye.y() >> c.eye.z() >> c.center.x() >> c.center.y() >> c.center.z() >>
+                  c.up.x() >> c.up.y() >> c.up.z()))
+                return fail("camera <entity> <eye n e d> <center n e d> <up n e d>");
+            if (!scenario_detail::find(s.entities, entity, c.entity))
+                return fail("unknown entity " + entity);
+        }
+        else
+            return fail("unknown directive " + key);
+    }
+
+    if (s.entities.empty())
+    {
+        std::cerr << file << ": no entities\n";
+        return false;
+    }
+    std::cout << "Scenario " << file << ": " << s.models.size() << " models, " << s.tracks.size() << " tracks, "
+              << s.entities.size() << " entities\n";
+    out = std::move(s);
+    return true;
+}
+
+inline bool saveScenario(const std::string &file, const Scenario &s)
+{
+    if (s.entities.empty())
+    {
+        std::cerr << "Scenario without entities not written\n";
+        return false;
+    }
+    std::ofstream out(file);
+    if (!out)
+    {
+        std::cerr << "Cannot open " << file << "\n";
+        return false;
+    }
+
+    out << "# osgtrn054 scenario\n";
+    out << "reserve " << s.models.size() << " " << s.tracks.size() << " " << s.entities.size() << "\n";
+    if (!s.dataPath.empty())
+        out << "datapath " << s.dataPath << "\n";
+    for (const ScenarioModel &m : s.models)
+    {
+        out << "model " << m.name << " " << m.file << " " << (m.display == ScenarioModel::F14 ? "f14" : "missile")
+            << std::setprecision(9) << " " << m.basis.x() << " " << m.basis.y() << " " << m.basis.z() << " "
+            << m.basis.w() << std::setprecision(6) << "\n";
+    }
+    for (const ScenarioTrack &t : s.tracks)
+        out << "track " << t.name << " " << t.file << "\n";
+    for (const ScenarioEntity &e : s.entities)
+    {
+        out << "entity " << e.name << " " << s.models[e.model].name << " " << s.tracks[e.track].name << " " << e.set;
+        if (e.trail)
+        {
+            out << " trail " << e.trailPoints << " " << e.trailSegment << " " << e.trailTail << " " << e.trailColor.r()
+                << " " << e.trailColor.g() << " " << e.trailColor.b() << " " << e.trailColor.a();
+        }
+        out << "\n";
+    }
+    const ScenarioCamera &c = s.camera;
+    out << "camera " << s.entities[c.entity].name << " " << c.eye.x() << " " << c.eye.y() << " " << c.eye.z() << " "
+        << c.center.x() << " " << c.center.y() << " " << c.center.z() << " " << c.up.x() << " " << c.up.y() << " "
+        << c.up.z() << "\n";
+    std::cout << "Scenario written: " << file << "\n";
+    return bool(out);
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include <osg/Array>
+#include <osg/Vec3>
+#include <osg/Vec3d>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+// TrailHistory
+// ------------
+// Time-indexed store of trail points. Samples are kept sorted by t in two
+// parallel arrays so that the trail at any timeline position is a plain
+// slice [0, upperBound(t)) and no re-simulation is needed when scrubbing.
+//
+// Points are world positions in double precision; slice() hands them to
+// the renderer as float offsets from an anchor near the newest point.
+//
+// Binary layout (native endianness):
+//   char[4]  magic "TRLH"
+//   uint32   version (2; version 1 files with float xyz are still read)
+//   uint32   count
+//   float    t[count]
+//   double   xyz[count * 3]
+//
+class TrailHistory
+{
+public:
+    void clear()
+    {
+        _t.clear();
+        _p.clear();
+    }
+
+    bool empty() const { return _t.empty(); }
+    size_t size() const { return _t.size(); }
+    float lastTime() const { return _t.empty() ? 0.0f : _t.back(); }
+
+    // Appends a sample. Recording at a time earlier than the last sample
+    // (e.g. after scrubbing back and resuming) rewrites the future.
+    void record(float t, const osg::Vec3d &p)
+    {
+        if (!_t.empty() && t < _t.back())
+            truncate(t);
+        _t.push_back(t);
+        _p.push_back(p);
+    }
+
+    // Drops every sample with time > t.
+    void truncate(float t)
+    {
+        const size_t n = upperBound(t);
+        _t.resize(n);
+        _p.resize(n);
+    }
+
+    // Index of the first sample with time > t.
+    size_t upperBound(float t) const
+    {
+        return std::upper_bound(_t.begin(), _t.end(), t) - _t.begin();
+    }
+
+    // Copies the newest maxPoints samples with time <= t into verts, relative
+    // to anchor. The anchor is moved to the newest copied sample.
+    void slice(float t, size_t maxPoints, osg::Vec3d &anchor, osg::Vec3Array *verts) const
+    {
+        const size_t end = upperBound(t);
+        const size_t begin = end > maxPoints ? end - maxPoints : 0;
+        if (end > 0)
+            anchor = _p[end - 1];
+        verts->resize(end - begin);
+        for (size_t i = begin; i < end; ++i)
+            (*verts)[i - begin] = osg::Vec3(_p[i] - anchor);
+    }
+
+    bool write(std::ostream &out) const
+    {
+        const uint32_t version = 2;
+        const uint32_t count = static_cast<uint32_t>(_t.size());
+        out.write(MAGIC, 4);
+        out.write(reinterpret_cast<const char *>(&version), sizeof(version));
+        out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char *>(_t.data()), count * sizeof(float));
+        out.write(reinterpret_cast<const char *>(_p.data()), count * sizeof(osg::Vec3d));
+        return bool(out);
+    }
+
+    bool read(std::istream &in)
+    {
+        char magic[4];
+        uint32_t version = 0, count = 0;
+        in.read(magic, 4);
+        in.read(reinterpret_cast<char *>(&version), sizeof(version));
+        in.read(reinterpret_cast<char *>(&count), sizeof(count));
+        if (!in || !std::equal(magic, magic + 4, MAGIC) || (version != 1 && version != 2))
+            return false;
+
+        // A corrupt count must not turn into a huge allocation
+        const uint64_t pointSize = version == 1 ? sizeof(osg::Vec3) : sizeof(osg::Vec3d);
+        const std::streamoff left = remaining(in);
+        if (left < 0 || uint64_t(count) * (sizeof(float) + pointSize) > uint64_t(left))
+            return false;
+
+        std::vector<float> t(count);
+        std::vector<osg::Vec3d> p(count);
+        in.read(reinterpret_cast<char *>(t.data()), count * sizeof(float));
+        if (version == 1)
+        {
+            std::vector<osg::Vec3> pf(count);
+            in.read(reinterpret_cast<char *>(pf.data()), count * sizeof(osg::Vec3));
+            std::copy(pf.begin(), pf.end(), p.begin());
+        }
+        else
+            in.read(reinterpret_cast<char *>(p.data()), count * sizeof(osg::Vec3d));
+        if (!in || !std::is_sorted(t.begin(), t.end()))
+            return false;
+
+        _t.swap(t);
+        _p.swap(p);
+        return true;
+    }
+
+private:
+    // Bytes between the read position and the end, or -1 if unknown
+    static std::streamoff remaining(std::istream &in)
+    {
+        const std::streampos here = in.tellg();
+        if (here < 0)
+            return -1;
+        in.seekg(0, std::ios::end);
+        const std::streamoff left = in.tellg() - here;
+        in.seekg(here);
+        return in ? left : -1;
+    }
+
+    static constexpr const char MAGIC[4] = {'T', 'R', 'L', 'H'};
+    static_assert(sizeof(osg::Vec3) == 3 * sizeof(float), "osg::Vec3 must be tightly packed");
+    static_assert(sizeof(osg::Vec3d) == 3 * sizeof(double), "osg::Vec3d must be tightly packed");
+
+    std::vector<float> _t;
+    std::vector<osg::Vec3d> _p;
+};
+
+// ======================= Trail file helpers ===========================
+// Several histories (one per trail) stored back to back in one file.
+inline bool saveTrailHistories(const std::string &file, const std::vector<const TrailHistory *> &histories)
+{
+    std::ofstream out(file, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Cannot open " << file << "\n";
+        return false;
+    }
+    for (const TrailHistory *h : histories)
+    {
+        if (!h->write(out))
+            return false;
+    }
+    std::cout << "Trail history written: " << file << "\n";
+    return true;
+}
+
+inline bool loadTrailHistories(const std::string &file, const std::vector<TrailHistory *> &histories)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Cannot open " << file << "\n";
+        return false;
+    }
+    // All or nothing: the trails are only replaced once every one has parsed
+    std::vector<TrailHistory> loaded(histories.size());
+    for (TrailHistory &h : loaded)
+    {
+        if (!h.read(in))
+        {
+            std::cerr << "Invalid trail history in " << file << "\n";
+            return false;
+        }
+    }
+    for (size_t i = 0; i < histories.size(); ++i)
+        *histories[i] = std::move(loaded[i]);
+    std::cout << "Trail history loaded: " << file << "\n";
+    return true;
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <osg/Vec3d>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//
+// TrajectorySpline
+// ----------------
+// Cubic Hermite curve through timed samples, with Catmull-Rom tangents
+// (central differences over the neighbouring samples, scaled for uneven
+// spacing). Position and first derivative are continuous across samples,
+// so the heading no longer kinks at every sample the way linear
+// interpolation does.
+//
+// Each segment also keeps an arc-length table (SUBDIVISIONS chords). It
+// maps distance to (segment, u) for constant-speed playback, i.e. the same
+// ground speed through tight turns and straight legs.
+//
+// Lookups start from the segment found by the previous call. Playback
+// moves forward a little each frame, so that is O(1); a jump (seek) falls
+// back to a binary search. Evaluation inside a segment is a fixed amount
+// of work: position, unit tangent and curvature from the Hermite basis.
+//
+// append() may be called while the curve is in use (streamed samples).
+// A new sample only changes the tangent of the previous one, so only the
+// last two segments are rebuilt.
+//
+class TrajectorySpline
+{
+public:
+    static constexpr int SUBDIVISIONS = 16;
+
+    struct Sample
+    {
+        osg::Vec3d position;
+        osg::Vec3d tangent; // unit direction of travel
+        double curvature = 0.0; // 1 / turn radius
+    };
+
+    void clear()
+    {
+        _t.clear();
+        _p.clear();
+        _m.clear();
+        _arc.clear();
+        _cursor = 0;
+    }
+
+    bool empty() const { return _t.empty(); }
+    size_t size() const { return _t.size(); }
+    double startTime() const { return _t.empty() ? 0.0 : _t.front(); }
+    double endTime() const { return _t.empty() ? 0.0 : _t.back(); }
+    double length() const { return _arc.empty() ? 0.0 : _arc.back(); }
+
+    // Adds a sample; samples not later than the last one are ignored
+    void append(double t, const osg::Vec3d &p)
+    {
+        if (!_t.empty() && t <= _t.back())
+            return;
+        _t.push_back(t);
+        _p.push_back(p);
+        _m.push_back(osg::Vec3d());
+
+        const size_t n = _t.size();
+        if (n == 1)
+            return;
+        // The new endpoint gets a one-sided tangent; its neighbour becomes central
+        _m[n - 1] = (_p[n - 1] - _p[n - 2]) / (_t[n - 1] - _t[n - 2]);
+        _m[n - 2] = n == 2 ? _m[n - 1] : (_p[n - 1] - _p[n - 3]) / (_t[n - 1] - _t[n - 3]);
+        if (n == 2)
+            _m[0] = _m[1];
+
+        rebuildArc(n >= 3 ? n - 3 : 0);
+    }
+
+    // Curve at time t (clamped to the sampled range)
+    Sample at(double t) const
+    {
+        if (_t.size() < 2)
+            return single();
+        t = std::min(std::max(t, _t.front()), _t.back());
+        const size_t i = locate(t);
+        return evaluate(i, (t - _t[i]) / (_t[i + 1] - _t[i]));
+    }
+
+    // Curve at distance s from the first sample (clamped to [0, length()])
+    Sample atDistance(double s) const
+    {
+        if (_t.size() < 2)
+            return single();
+        size_t i;
+        const double u = arcToParam(s, i);
+        return evaluate(i, u);
+    }
+
+    // Time at which the curve has travelled distance s
+    double timeAtDistance(double s) const
+    {
+        if (_t.size() < 2)
+            return startTime();
+        size_t i;
+        const double u = arcToParam(s, i);
+        return _t[i] + u * (_t[i + 1] - _t[i]);
+    }
+
+    // Distance travelled at time t
+    double distanceAtTime(double t) const
+    {
+        if (_t.size() < 2)
+            return 0.0;
+        t = std::min(std::max(t, _t.front()), _t.back());
+        const size_t i = locate(t);
+        const double x = (t - _t[i]) / (_t[i + 1] - _t[i]) * SUBDIVISIONS;
+        const size_t k = std::min(static_cast<size_t>(x), static_cast<size_t>(SUBDIVISIONS - 1));
+        const double *a = &_arc[i * SUBDIVISIONS + k];
+        return a[0] + (x - k) * (a[1] - a[0]);
+    }
+
+private:
+    Sample single() const
+    {
+        Sample s;
+        if (!_p.empty())
+            s.position = _p.front();
+        s.tangent.set(1.0, 0.0, 0.0);
+        return s;
+    }
+
+    // Segment i with t[i] <= t <= t[i + 1]; tries the last segment and its
+    // successor before searching
+    size_t locate(double t) const
+    {
+        const size_t last = _t.size() - 2;
+        size_t i = std::min(_cursor, last);
+        if (_t[i] <= t && t <= _t[i + 1])
+            return i;
+        if (i < last && _t[i + 1] <= t && t <= _t[i + 2])
+            return _cursor = i + 1;
+        i = std::upper_bound(_t.begin(), _t.end(), t) - _t.begin();
+        return _cursor = std::min(i == 0 ? 0 : i - 1, last);
+    }
+
+    // Segment i and Hermite parameter u at distance s
+    double arcToParam(double s, size_t &i) const
+    {
+        s = std::min(std::max(s, 0.0), length());
+        // Segment starts sit every SUBDIVISIONS entries of the table
+        const size_t last = _t.size() - 2;
+        i = std::min(_cursor, last);
+        if (!(segmentStart(i) <= s && s <= segmentStart(i + 1)))
+        {
+            if (i < last && segmentStart(i + 1) <= s && s <= segmentStart(i + 2))
+                ++i;
+            else
+            {
+                size_t lo = 0, hi = last;
+                while (lo < hi)
+                {
+                    const size_t mid = (lo + hi + 1) / 2;
+                    if (segmentStart(mid) <= s)
+                        lo = mid;
+                    else
+                        hi = mid - 1;
+                }
+                i = lo;
+            }
+            _cursor = i;
+        }
+
+        const double *a = &_arc[i * SUBDIVISIONS];
+        const size_t k = std::upper_bound(a + 1, a + SUBDIVISIONS, s) - (a + 1);
+        const double span = a[k + 1] - a[k];
+        const double f = span > 0.0 ? (s - a[k]) / span : 0.0;
+        return (k + f) / SUBDIVISIONS;
+    }
+
+    double segmentStart(size_t i) const { return _arc[i * SUBDIVISIONS]; }
+
+    Sample evaluate(size_t i, double u) const
+    {
+        const double h = _t[i + 1] - _t[i];
+        const osg::Vec3d &p0 = _p[i], &p1 = _p[i + 1];
+        const osg::Vec3d m0 = _m[i] * h, m1 = _m[i + 1] * h;
+        const double u2 = u * u, u3 = u2 * u;
+
+        Sample s;
+        s.position = p0 * (2 * u3 - 3 * u2 + 1) + m0 * (u3 - 2 * u2 + u) +
+                     p1 * (-2 * u3 + 3 * u2) + m1 * (u3 - u2);
+        // Derivatives with respect to u; curvature does not depend on the scale
+        const osg::Vec3d d1 = p0 * (6 * u2 - 6 * u) + m0 * (3 * u2 - 4 * u + 1) +
+                              p1 * (-6 * u2 + 6 * u) + m1 * (3 * u2 - 2 * u);
+        const osg::Vec3d d2 = p0 * (12 * u - 6) + m0 * (6 * u - 4) +
+                              p1 * (-12 * u + 6) + m1 * (6 * u - 2);
+        const double speed = d1.length();
+        if (speed > 1e-12)
+        {
+            s.tangent = d1 / speed;
+            s.curvature = (d1 ^ d2).length() / (speed * speed * speed);
+        }
+        else
+        {
+            // Stationary for an instant: fall back to the chord
+            s.tangent = p1 - p0;
+            if (s.tangent.normalize() == 0.0)
+                s.tangent.set(1.0, 0.0, 0.0);
+        }
+        return s;
+    }
+
+    // Recomputes the distance table from segment `first` to the end
+    void rebuildArc(size_t first)
+    {
+        const size_t segments = _t.size() - 1;
+        _arc.resize(segments * SUBDIVISIONS + 1);
+        if (first == 0)
+            _arc[0] = 0.0;
+        for (size_t i = first; i < segments; ++i)
+        {
+            double *a = &_arc[i * SUBDIVISIONS];
+            osg::Vec3d prev = _p[i];
+            for (int k = 1; k <= SUBDIVISIONS; ++k)
+            {
+                const osg::Vec3d p = evaluate(i, double(k) / SUBDIVISIONS).position;
+                a[k] = a[k - 1] + (p - prev).length();
+                prev = p;
+            }
+        }
+    }
+
+    std::vector<double> _t;
+    std::vector<osg::Vec3d> _p;
+    std::vector<osg::Vec3d> _m; // dp/dt at each sample
+    std::vector<double> _arc;   // distance at u = k / SUBDIVISIONS of each segment, shared ends
+    mutable size_t _cursor = 0;
+};
@@ -4,6 +4,9 @@
 #include <sstream>
 #include <vector>
 #include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <osg/ArgumentParser>
 #include <osgViewer/Viewer>
 #include <osgViewer/config/SingleWindow>
 #include <osg/MatrixTransform>
@@ -16,6 +19,16 @@
 #include <imgui.h>
 #include <imgui_impl_opengl3.h>
 #include "OsgImGuiHandler.hpp"
+#include "TrailHistory.hpp"
+#include "InputRecorder.hpp"
+#include "RenderOrigin.hpp"
+#include "Frames.hpp"
+#include "OrientationKernel.hpp"
+#include "TrajectorySpline.hpp"
+#include "LiveFeed.hpp"
+#include "LiveFeedGenerator.hpp"
+#include "DeadReckoning.hpp"
+#include "ScenarioFile.hpp"
 
 // ======================= ImGui Init ===========================
 class ImGuiInitOperation : public osg::Operation
@@ -40,32 +53,30 @@ struct AnimationState
     bool running = false;
     float t = 0.0f;
     float speed = 0.25f;
-    bool isFighter = false;
+    bool constantSpeed = false; // t is the fraction of path length, not of time
 } gAnim;
-float gTailOffset = -14.0f;
 const osg::Vec3 WORLD_UP(0, 0, -1);
 
-const osg::Quat F14_BASIS(-0.00622421, 0.713223, -0.700883, -0.0061165);
-const osg::Quat MISSILE_BASIS(0, 0, 1, 0);
-
 // ======================= Trajectory functions ===========================
-osg::Vec3 aircraftFunc(float t)
+// World positions are NED metres in double precision
+osg::Vec3d aircraftFunc(double t)
 {
-    float x = -120.0f + 240.0f * t;
-    float y = 15.0f * sinf(1.5f * 2.0f * osg::PI * t);
-    float z = 15.0f * sinf(1.5f * 2.0f * osg::PI * t);
-    return osg::Vec3(x, y, z);
+    double x = -120.0 + 240.0 * t;
+    double y = 15.0 * sin(1.5 * 2.0 * osg::PI * t);
+    double z = 15.0 * sin(1.5 * 2.0 * osg::PI * t);
+    return osg::Vec3d(x, y, z);
 }
-osg::Vec3 missileFunc(float t)
+osg::Vec3d missileFunc(double t)
 {
-    float x = -120.0f + 260.0f * t + 10.0f;
-    float y = 25.0f * sinf(1.2f * osg::PI * t);
-    float z = -5.0f * t;
-    return osg::Vec3(x, y, z);
+    double x = -120.0 + 260.0 * t + 10.0;
+    double y = 25.0 * sin(1.2 * osg::PI * t);
+    double z = -5.0 * t;
+    return osg::Vec3d(x, y, z);
 }
 
 // ======================= File I/O ===========================
-void generateTrajectoryFile(const std::string &file)
+// offset moves the whole engagement, e.g. hundreds of km from the NED origin
+void generateTrajectoryFile(const std::string &file, const osg::Vec3d &offset = osg::Vec3d())
 {
     std::ofstream out(file);
     if (!out)
@@ -79,8 +90,8 @@ void generateTrajectoryFile(const std::string &file)
     for (int i = 0; i <= N; ++i)
     {
         float t = float(i) / N;
-        osg::Vec3 a = aircraftFunc(t);
-        osg::Vec3 m = missileFunc(t);
+        osg::Vec3d a = aircraftFunc(t) + offset;
+        osg::Vec3d m = missileFunc(t) + offset;
         out << std::fixed << std::setprecision(6)
             << t << " " << a.x() << " " << a.y() << " " << a.z() << " "
             << m.x() << " " << m.y() << " " << m.z() << "\n";
@@ -88,97 +99,107 @@ void generateTrajectoryFile(const std::string &file)
     std::cout << "Trajectory file written: " << file << "\n";
 }
 
-struct TrajData
-{
-    std::vector<float> t;
-    std::vector<osg::Vec3> aircraft, missile;
-};
-
-TrajData loadTrajectoryFile(const std::string &file)
+// One spline per xyz triple after t; sets are appended to while streaming
+std::vector<TrajectorySpline> loadTrajectorySets(const std::string &file)
 {
-    TrajData data;
+    std::vector<TrajectorySpline> sets;
     std::ifstream in(file);
     if (!in)
     {
         std::cerr << "Cannot open " << file << "\n";
-        return data;
+        return sets;
     }
     std::string line;
+    std::vector<double> values;
     while (std::getline(in, line))
     {
         if (line.empty() || line[0] == '#')
             continue;
         std::istringstream ss(line);
-        float t, ax, ay, az, mx, my, mz;
-        if (ss >> t >> ax >> ay >> az >> mx >> my >> mz)
-        {
-            data.t.push_back(t);
-            data.aircraft.push_back({ax, ay, az});
-            data.missile.push_back({mx, my, mz});
-        }
+        double t, v;
+        if (!(ss >> t))
+            continue;
+        values.clear();
+        while (ss >> v)
+            values.push_back(v);
+        if (sets.empty())
+            sets.resize(values.size() / 3);
+        if (values.size() < sets.size() * 3)
+            continue;
+        for (size_t k = 0; k < sets.size(); ++k)
+            sets[k].append(t, osg::Vec3d(values[3 * k], values[3 * k + 1], values[3 * k + 2]));
     }
-    std::cout << "Loaded " << data.t.size() << " samples from " << file << "\n";
-    return data;
+    std::cout << "Loaded " << sets.size() << " tracks of " << (sets.empty() ? 0 : sets[0].size())
+              << " samples from " << file << "\n";
+    return sets;
 }
 
-// ======================= Interpolation ===========================
-osg::Vec3 interpolate(const std::vector<float> &tvec,
-                      const std::vector<osg::Vec3> &vals, float t)
+// The scenario this demo used to hard-code: one F-14 and one missile on
+// the two tracks of the generated trajectory file
+Scenario defaultScenario(const std::string &trajFile, const std::string &dataPath)
 {
-    if (tvec.empty())
-        return osg::Vec3();
-    if (t <= tvec.front())
-        return vals.front();
-    if (t >= tvec.back())
-        return vals.back();
-    for (size_t i = 1; i < tvec.size(); ++i)
-    {
-        if (t < tvec[i])
-        {
-            float u = (t - tvec[i - 1]) / (tvec[i] - tvec[i - 1]);
-            return vals[i - 1] * (1.0f - u) + vals[i] * u;
-        }
-    }
-    return vals.back();
+    Scenario s;
+    s.dataPath = dataPath;
+    s.models.push_back({"f14", "F-14-low-poly-no-land-gear.ac", ScenarioModel::F14,
+                        osg::Quat(-0.00622421, 0.713223, -0.700883, -0.0061165)});
+    s.models.push_back({"aim9", "AIM-9L.ac", ScenarioModel::Missile, osg::Quat(0, 0, 1, 0)});
+    s.tracks.push_back({"engagement", trajFile});
+
+    ScenarioEntity f14;
+    f14.name = "F14";
+    f14.trail = true;
+    f14.trailPoints = 2000;
+    f14.trailTail = 14.0f;
+    ScenarioEntity aim9;
+    aim9.name = "AIM9";
+    aim9.model = 1;
+    aim9.set = 1;
+    aim9.trail = true;
+    aim9.trailPoints = 1500;
+    aim9.trailTail = 5.0f;
+    aim9.trailColor.set(1.0f, 0.2f, 0.2f, 1.0f);
+    s.entities = {f14, aim9};
+    return s;
 }
 
-// ======================= Orientation helper ===========================
-static osg::Quat orientationFromTangent(const osg::Vec3 &fwd, const osg::Vec3 &up, bool isFighter)
+// ======================= Playback ===========================
+// Timeline position t in [0, 1] either spans the sampled time range or,
+// with constantSpeed, the path length
+TrajectorySpline::Sample sampleAt(const TrajectorySpline &path, float t)
 {
-    osg::Vec3 X = fwd;
-    X.normalize();
-    osg::Vec3 Z = -(up - X * (up * X));
-    Z.normalize();
-    osg::Vec3 Y = Z ^ X;
-    Y.normalize();
-    osg::Matrix R(X.x(), Y.x(), Z.x(), 0, X.y(), Y.y(), Z.y(), 0,
-                  X.z(), Y.z(), Z.z(), 0, 0, 0, 0, 1);
-
-    auto rotX = R.getRotate().x();
-    auto rotY = R.getRotate().y();
-    auto rotZ = R.getRotate().z();
-    auto rotW = R.getRotate().w();
-
-    osg::Quat q;
-
-    if (isFighter)
-    {
-        q = osg::Quat(rotX, rotZ, rotY, rotW);
-    }
-    else
-    {
-        q = osg::Quat(rotX, rotY, -rotZ, rotW);
-    }
+    if (gAnim.constantSpeed)
+        return path.atDistance(t * path.length());
+    return path.at(path.startTime() + t * (path.endTime() - path.startTime()));
+}
 
-    return q;
+// ======================= Orientation helper ===========================
+// Body attitude in NED, in the display frame a model is built in
+static osg::Quat displayAttitude(const frame::Quat<frame::Ned> &attitude, ScenarioModel::Display display)
+{
+    return display == ScenarioModel::F14 ? frame::convert<frame::F14Display>(attitude).raw()
+                                         : frame::convert<frame::MissileDisplay>(attitude).raw();
 }
 
+// A scenario model once loaded; shared by every entity that uses it
+struct SceneModel
+{
+    osg::ref_ptr<osg::Node> node;
+    osg::Quat basis;
+    ScenarioModel::Display display;
+};
+
 // ======================= Trail ===========================
+// Vertices are float offsets from _anchor (a recent trail point, double).
+// The geode hangs under a transform at anchor - render origin, so a rebase
+// moves one matrix; the vertices are only rewritten when the trail has
+// travelled REANCHOR_DISTANCE from its anchor.
 class Trail : public osg::Referenced
 {
 public:
-    Trail(size_t maxPoints = 2000, float minSegment = 0.2f)
-        : _maxPoints(maxPoints), _minSegment(minSegment)
+    static constexpr double REANCHOR_DISTANCE = 2000.0;
+
+    Trail(RenderOrigin *origin, size_t maxPoints = 2000, float minSegment = 0.2f)
+        : _origin(origin), _maxPoints(maxPoints), _minSegment(minSegment)
     {
         _verts = new osg::Vec3Array;
         _geom = new osg::Geometry;
@@ -200,36 +221,106 @@ public:
 
         _geode = new osg::Geode;
         _geode->addDrawable(_geom.get());
+        _xform = new osg::MatrixTransform;
+        _xform->addChild(_geode.get());
     }
 
     osg::Geode *geode() const { return _geode.get(); }
+    osg::MatrixTransform *node() const { return _xform.get(); }
 
+    void setColor(const osg::Vec4 &color)
+    {
+        osg::ref_ptr<osg::Vec4Array> col = new osg::Vec4Array;
+        col->push_back(color);
+        _geom->setColorArray(col, osg::Array::BIND_OVERALL);
+    }
+
+    TrailHistory &history() { return _history; }
+
+    // Drops the visible trail and its recorded history
     void clear()
     {
+        _history.clear();
         _verts->clear();
-        _draw->setCount(0);
-        _geom->dirtyDisplayList();
-        _geom->dirtyBound();
+        _shownT = 0.0f;
+        dirty();
     }
 
-    void add(const osg::Vec3 &p)
+    // Appends a world point recorded at timeline position t
+    void add(float t, const osg::Vec3d &p)
     {
-        if (_verts->empty() || (p - _verts->back()).length() >= _minSegment)
+        if (t < _shownT)
+            scrubTo(t);
+        _shownT = t;
+        place();
+        if (_verts->empty())
+            _anchor = p;
+        const osg::Vec3 local(p - _anchor);
+        if (_verts->empty() || (local - _verts->back()).length() >= _minSegment)
         {
-            _verts->push_back(p);
-            _draw->setCount(_verts->size());
-            _geom->dirtyDisplayList();
-            _geom->dirtyBound();
+            _history.record(t, p);
+            if ((p - _anchor).length() > REANCHOR_DISTANCE)
+            {
+                refresh();
+                return;
+            }
+            _verts->push_back(local);
+            if (_verts->size() > _maxPoints)
+            {
+                const size_t overflow = _verts->size() - _maxPoints;
+                _verts->erase(_verts->begin(), _verts->begin() + overflow);
+            }
+            dirty();
         }
-        if (_verts->size() > _maxPoints)
+    }
+
+    // Rebuilds the visible trail as it was at timeline position t
+    void scrubTo(float t)
+    {
+        if (t == _shownT)
         {
-            const size_t overflow = _verts->size() - _maxPoints;
-            _verts->erase(_verts->begin(), _verts->begin() + overflow);
-            _draw->setCount(_verts->size());
+            place();
+            return;
         }
+        _history.slice(t, _maxPoints, _anchor, _verts.get());
+        _shownT = t;
+        dirty();
+    }
+
+    // Rebuilds the visible trail after the history was replaced
+    void refresh()
+    {
+        _history.slice(_shownT, _maxPoints, _anchor, _verts.get());
+        dirty();
     }
 
 private:
+    // Keeps the trail transform at anchor - origin; cheap when neither moved
+    void place()
+    {
+        if (_placedGeneration == _origin->generation() && _placedAnchor == _anchor)
+            return;
+        _placedGeneration = _origin->generation();
+        _placedAnchor = _anchor;
+        _xform->setMatrix(osg::Matrix::translate(_origin->toRender(_anchor)));
+    }
+
+    void dirty()
+    {
+        place();
+        _draw->setCount(_verts->size());
+        _verts->dirty();
+        _geom->dirtyDisplayList();
+        _geom->dirtyBound();
+    }
+
+    TrailHistory _history;
+    float _shownT = 0.0f;
+    osg::ref_ptr<RenderOrigin> _origin;
+    osg::Vec3d _anchor;
+    osg::Vec3d _placedAnchor;
+    unsigned int _placedGeneration = ~0u;
+    osg::ref_ptr<osg::MatrixTransform> _xform;
     osg::ref_ptr<osg::Vec3Array> _verts;
     osg::ref_ptr<osg::Geometry> _geom;
     osg::ref_ptr<osg::DrawArrays> _draw;
@@ -238,12 +329,33 @@ private:
     float _minSegment;
 };
 
-// ======================= Motion Callbacks ===========================
-class F14CB : public osg::NodeCallback
+// ======================= Scenario Entities ===========================
+// Every scenario entity in one callback: advances the timeline, samples
+// all paths, gets all attitudes from one batched kernel call, then places
+// the transforms and feeds the trails. Entity data sits in parallel
+// arrays sized once when the scene is built.
+class ScenarioEntitiesCB : public osg::NodeCallback
 {
 public:
-    F14CB(osg::MatrixTransform *m, Trail *t, const TrajData *d) : mt(m), trail(t), data(d) {}
-    void operator()(osg::Node *, osg::NodeVisitor *nv) override
+    struct Entity
+    {
+        const TrajectorySpline *path;
+        const SceneModel *model;
+        osg::ref_ptr<osg::MatrixTransform> xform;
+        osg::ref_ptr<Trail> trail; // may be null
+        double tail;
+    };
+
+    ScenarioEntitiesCB(std::vector<Entity> entities, RenderOrigin *o)
+        : entities(std::move(entities)), origin(o)
+    {
+        const size_t n = this->entities.size();
+        samples.resize(n);
+        for (std::vector<float> *v : {&fx, &fy, &fz, &qx, &qy, &qz, &qw})
+            v->resize(n);
+    }
+
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
     {
         if (gAnim.running)
         {
@@ -251,125 +363,419 @@ public:
             if (gAnim.t > 1.0f)
                 gAnim.t = 1.0f;
         }
-        osg::Vec3 p = interpolate(data->t, data->aircraft, gAnim.t);
-        osg::Vec3 p2 = interpolate(data->t, data->aircraft, std::min(1.0f, gAnim.t + 0.01f));
-        osg::Vec3 fwd = (p2 - p);
-        fwd.normalize();
-        osg::Quat q = orientationFromTangent(fwd, WORLD_UP, true) * F14_BASIS;
-        mt->setMatrix(osg::Matrix::rotate(q) * osg::Matrix::translate(p));
-        if (trail.valid())
-            trail->add(p - (q * osg::Vec3(1, 0, 0)) * gTailOffset);
-        traverse(mt.get(), nv);
+
+        const size_t n = entities.size();
+        for (size_t i = 0; i < n; ++i)
+        {
+            samples[i] = sampleAt(*entities[i].path, gAnim.t);
+            fx[i] = float(samples[i].tangent.x());
+            fy[i] = float(samples[i].tangent.y());
+            fz[i] = float(samples[i].tangent.z());
+        }
+        orientation::attitudesFromTangents(n, fx.data(), fy.data(), fz.data(), WORLD_UP, osg::Vec3(1, 0, 0),
+                                           qx.data(), qy.data(), qz.data(), qw.data());
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const Entity &e = entities[i];
+            const osg::Vec3d &p = samples[i].position;
+            const frame::Quat<frame::Ned> attitude(osg::Quat(qx[i], qy[i], qz[i], qw[i]));
+            const osg::Quat q = displayAttitude(attitude, e.model->display) * e.model->basis;
+            e.xform->setMatrix(osg::Matrix::rotate(q) * osg::Matrix::translate(origin->toRender(p)));
+            if (e.trail.valid())
+            {
+                if (gAnim.running)
+                    e.trail->add(gAnim.t, p - samples[i].tangent * e.tail);
+                else
+                    e.trail->scrubTo(gAnim.t);
+            }
+        }
+        traverse(node, nv);
     }
 
 private:
-    osg::observer_ptr<osg::MatrixTransform> mt;
-    osg::observer_ptr<Trail> trail;
-    const TrajData *data;
+    std::vector<Entity> entities;
+    osg::ref_ptr<RenderOrigin> origin;
+    std::vector<TrajectorySpline::Sample> samples;
+    std::vector<float> fx, fy, fz, qx, qy, qz, qw;
 };
 
-class MissileCB : public osg::NodeCallback
+// ======================= Live Entities ===========================
+// One transform per feed entity, spawned the first time its id arrives and
+// sharing the fighter or missile model. New states go to dead reckoning;
+// each frame every entity is placed at its predicted position, facing
+// along its predicted velocity. Both passes are batched over all entities.
+class LiveEntitiesCB : public osg::NodeCallback
 {
 public:
-    MissileCB(osg::MatrixTransform *m, Trail *t, const TrajData *d) : mt(m), trail(t), data(d) {}
-    void operator()(osg::Node *, osg::NodeVisitor *nv) override
+    LiveEntitiesCB(LiveFeed *f, RenderOrigin *o, const SceneModel &fighter, const SceneModel &missile,
+                   const DeadReckoning::Settings &settings)
+        : feed(f), origin(o), fighterModel(fighter), missileModel(missile)
     {
-        osg::Vec3 p = interpolate(data->t, data->missile, gAnim.t);
-        osg::Vec3 p2 = interpolate(data->t, data->missile, std::min(1.0f, gAnim.t + 0.01f));
-        osg::Vec3 fwd = (p2 - p);
-        fwd.normalize();
-        osg::Quat q = orientationFromTangent(fwd, WORLD_UP, false) * MISSILE_BASIS;
-        mt->setMatrix(osg::Matrix::rotate(q) * osg::Matrix::translate(p));
-        if (trail.valid())
-            trail->add(p - fwd * 5.0f);
-        traverse(mt.get(), nv);
+        reckoning.settings() = settings;
+    }
+    void operator()(osg::Node *node, osg::NodeVisitor *nv) override
+    {
+        feed->poll();
+        const std::vector<LiveFeed::Entity> &entities = feed->entities();
+        const size_t n = entities.size();
+
+        osg::Group *group = node->asGroup();
+        while (xforms.size() < n)
+        {
+            osg::ref_ptr<osg::MatrixTransform> mt = new osg::MatrixTransform;
+            mt->addChild(entities[xforms.size()].kind == 0 ? fighterModel.node.get() : missileModel.node.get());
+            group->addChild(mt);
+            xforms.push_back(mt);
+            reckoning.add();
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const LiveFeed::Entity &e = entities[i];
+            if (e.time != reckoning.stateTime(i))
+                reckoning.correct(i, e.time, e.position, e.velocity, e.receivedAt);
+        }
+        reckoning.update(LiveFeed::now());
+
+        for (std::vector<float> *v : {&qx, &qy, &qz, &qw})
+            v->resize(n);
+        orientation::attitudesFromTangents(n, reckoning.headingX(), reckoning.headingY(), reckoning.headingZ(),
+                                           WORLD_UP, osg::Vec3(1, 0, 0), qx.data(), qy.data(), qz.data(), qw.data());
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const frame::Quat<frame::Ned> attitude(osg::Quat(qx[i], qy[i], qz[i], qw[i]));
+            const SceneModel &model = entities[i].kind == 0 ? fighterModel : missileModel;
+            const osg::Quat q = displayAttitude(attitude, model.display) * model.basis;
+            xforms[i]->setMatrix(osg::Matrix::rotate(q) *
+                                 osg::Matrix::translate(origin->toRender(reckoning.position(i))));
+        }
+        traverse(node, nv);
     }
 
 private:
-    osg::observer_ptr<osg::MatrixTransform> mt;
-    osg::observer_ptr<Trail> trail;
-    const TrajData *data;
+    osg::ref_ptr<LiveFeed> feed;
+    osg::ref_ptr<RenderOrigin> origin;
+    SceneModel fighterModel, missileModel;
+    std::vector<osg::ref_ptr<osg::MatrixTransform>> xforms;
+    DeadReckoning reckoning;
+    std::vector<float> qx, qy, qz, qw; // reused every frame
+};
+
+// ======================= Scenario Scene ===========================
+// Everything a scenario turns into, built in one pass. Models and track
+// files are loaded once each however many entities use them; the pools
+// are sized up front and never reallocated, since the entity callback
+// keeps pointers into them.
+struct ScenarioScene
+{
+    std::vector<SceneModel> models;
+    std::vector<std::vector<TrajectorySpline>> tracks;
+    std::vector<osg::ref_ptr<Trail>> trails;
+    osg::ref_ptr<osg::Group> entities;
+    osg::ref_ptr<osg::MatrixTransform> tracked;
+
+    bool build(const Scenario &scenario, RenderOrigin *origin)
+    {
+        models.resize(scenario.models.size());
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            const ScenarioModel &m = scenario.models[i];
+            models[i] = {osgDB::readRefNodeFile(scenario.dataPath + m.file), m.basis, m.display};
+            if (!models[i].node.valid())
+                std::cerr << "Cannot load model " << m.file << "\n";
+        }
+
+        tracks.resize(scenario.tracks.size());
+        for (size_t i = 0; i < tracks.size(); ++i)
+            tracks[i] = loadTrajectorySets(scenario.tracks[i].file);
+
+        std::vector<ScenarioEntitiesCB::Entity> pool;
+        pool.reserve(scenario.entities.size());
+        entities = new osg::Group;
+        for (const ScenarioEntity &e : scenario.entities)
+        {
+            const std::vector<TrajectorySpline> &sets = tracks[e.track];
+            if (e.set >= sets.size() || sets[e.set].empty())
+            {
+                std::cerr << "Entity " << e.name << ": track " << scenario.tracks[e.track].name << " has no set "
+                          << e.set << "\n";
+                continue;
+            }
+
+            ScenarioEntitiesCB::Entity entity{&sets[e.set], &models[e.model], new osg::MatrixTransform, nullptr,
+                                              e.trailTail};
+            if (models[e.model].node.valid())
+                entity.xform->addChild(models[e.model].node);
+            entity.xform->setName(e.name);
+            entities->addChild(entity.xform);
+            if (e.trail)
+            {
+                entity.trail = new Trail(origin, e.trailPoints, e.trailSegment);
+                entity.trail->setColor(e.trailColor);
+                entities->addChild(entity.trail->node());
+                trails.push_back(entity.trail);
+            }
+            if (&e == &scenario.entities[scenario.camera.entity])
+                tracked = entity.xform;
+            pool.push_back(entity);
+        }
+        if (pool.empty())
+            return false;
+
+        if (!tracked.valid())
+            tracked = pool.front().xform;
+        origin->reset(pool.front().path->at(pool.front().path->startTime()).position);
+        entities->addUpdateCallback(new ScenarioEntitiesCB(std::move(pool), origin));
+        return true;
+    }
+
+    // First model built in the given display frame, for live entities
+    const SceneModel *firstModel(ScenarioModel::Display display) const
+    {
+        for (const SceneModel &m : models)
+        {
+            if (m.display == display && m.node.valid())
+                return &m;
+        }
+        return nullptr;
+    }
 };
 
+// ======================= Sim Inputs ===========================
+// The only place UI actions reach the simulation; replay goes through here too
+void applyInput(const InputEvent &e, const std::vector<osg::ref_ptr<Trail>> &trails, const std::string &trailFile)
+{
+    switch (e.type)
+    {
+    case InputEvent::SetRunning:
+        gAnim.running = e.value != 0.0f;
+        break;
+    case InputEvent::SetSpeed:
+        gAnim.speed = e.value;
+        break;
+    case InputEvent::Seek:
+        gAnim.t = e.value;
+        break;
+    case InputEvent::SetConstantSpeed:
+        gAnim.constantSpeed = e.value != 0.0f;
+        break;
+    case InputEvent::Reset:
+        // Trails keep their history; rewinding only hides it
+        gAnim.t = 0.0f;
+        gAnim.running = false;
+        std::cout << "=== Animation reset ===\n";
+        break;
+    case InputEvent::ClearTrails:
+        for (const osg::ref_ptr<Trail> &trail : trails)
+            trail->clear();
+        std::cout << "=== Trails cleared ===\n";
+        break;
+    case InputEvent::LoadTrails:
+    {
+        std::vector<TrailHistory *> histories;
+        for (const osg::ref_ptr<Trail> &trail : trails)
+            histories.push_back(&trail->history());
+        if (loadTrailHistories(trailFile, histories))
+        {
+            gAnim.running = false;
+            for (const osg::ref_ptr<Trail> &trail : trails)
+                trail->refresh();
+        }
+        break;
+    }
+    }
+}
+
 // ======================= ImGui UI ===========================
 class ImGuiControl : public OsgImGuiHandler
 {
 public:
-    ImGuiControl(Trail *a, Trail *m) : ta(a), tm(m) {}
+    ImGuiControl(const std::vector<osg::ref_ptr<Trail>> &trails, InputRecorder *input, LiveFeed *feed,
+                 const std::string &trailFile, const std::string &inputFile)
+        : trails(trails), input(input), feed(feed), trailFile(trailFile), inputFile(inputFile) {}
 
 protected:
     void drawUi() override
     {
         ImGui::Begin("Trajectory Control");
         if (ImGui::Button(gAnim.running ? "Stop" : "Start"))
-            gAnim.running = !gAnim.running;
+            input->push(InputEvent::SetRunning, gAnim.running ? 0.0f : 1.0f);
         ImGui::SameLine();
         if (ImGui::Button("Reset"))
+            input->push(InputEvent::Reset);
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Trails"))
+            input->push(InputEvent::ClearTrails);
+
+        // Widgets edit copies; the change reaches gAnim on the next update
+        float speed = gAnim.speed;
+        if (ImGui::SliderFloat("Speed", &speed, 0.05f, 1.0f, "%.2f"))
+            input->push(InputEvent::SetSpeed, speed);
+        float t = gAnim.t;
+        if (ImGui::SliderFloat("t", &t, 0.0f, 1.0f, "%.3f"))
+            input->push(InputEvent::Seek, t);
+        bool constantSpeed = gAnim.constantSpeed;
+        if (ImGui::Checkbox("Constant speed", &constantSpeed))
+            input->push(InputEvent::SetConstantSpeed, constantSpeed ? 1.0f : 0.0f);
+
+        if (!trails.empty())
         {
-            gAnim.t = 0.0f;
-            gAnim.running = false;
-            if (ta.valid())
-                ta->clear();
-            if (tm.valid())
-                tm->clear();
-            std::cout << "=== Trails cleared and animation reset ===\n";
+            if (ImGui::Button("Save Trails"))
+            {
+                std::vector<const TrailHistory *> histories;
+                for (const osg::ref_ptr<Trail> &trail : trails)
+                    histories.push_back(&trail->history());
+                saveTrailHistories(trailFile, histories);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Load Trails"))
+                input->push(InputEvent::LoadTrails);
+            size_t samples = 0;
+            for (const osg::ref_ptr<Trail> &trail : trails)
+                samples += trail->history().size();
+            ImGui::Text("Trail samples: %zu in %zu trails", samples, trails.size());
+        }
+        if (feed.valid())
+            ImGui::Text("Live entities: %zu", feed->entities().size());
+
+        ImGui::Separator();
+        if (input->isReplaying())
+        {
+            ImGui::Text("Replaying frame %u / %zu", input->frame(), input->numRecordedFrames());
+        }
+        else
+        {
+            if (ImGui::Button("Save Input Log"))
+                input->requestSave(inputFile);
+            ImGui::SameLine();
+            ImGui::Text("%u frames, %zu events, seed %u", input->frame(), input->numEvents(), input->seed());
         }
-        ImGui::SliderFloat("Speed", &gAnim.speed, 0.05f, 1.0f, "%.2f");
-        ImGui::SliderFloat("t", &gAnim.t, 0.0f, 1.0f, "%.3f");
         ImGui::End();
     }
-    osg::observer_ptr<Trail> ta, tm;
+    std::vector<osg::ref_ptr<Trail>> trails;
+    osg::ref_ptr<InputRecorder> input;
+    osg::ref_ptr<LiveFeed> feed;
+    std::string trailFile;
+    std::string inputFile;
 };
 
 // ======================= Main ===========================
-int main()
+// Usage: osgtrn054 [--record <log>] [--replay <log>] [--offset <n> <e> <d>]
+//                  [--feed <udp port>] [--generate <entity count>]
+//                  [--dr-model cv|ca] [--dr-converge <s>] [--dr-threshold <m>]
+//                  [--scenario <file>]
+int main(int argc, char **argv)
 {
+    osg::ArgumentParser arguments(&argc, argv);
+    std::string inputFile = "/home/murate/Documents/SwTrn/OsgTrn/osgtrn054/input.log";
+    std::string replayFile;
+    osg::Vec3d offset;
+    arguments.read("--record", inputFile);
+    arguments.read("--replay", replayFile);
+    arguments.read("--offset", offset.x(), offset.y(), offset.z());
+    std::string scenarioFile;
+    arguments.read("--scenario", scenarioFile);
+    // Live entities: listen for an external sim, or run the local stand-in
+    unsigned int feedPort = 0, generateCount = 0;
+    arguments.read("--feed", feedPort);
+    arguments.read("--generate", generateCount);
+    if (generateCount > 0 && feedPort == 0)
+        feedPort = LiveFeed::DEFAULT_PORT;
+    // Dead reckoning; the generator only sends when the error passes the threshold
+    DeadReckoning::Settings reckoning;
+    std::string reckoningModel;
+    double sendThreshold = 0.0;
+    if (arguments.read("--dr-model", reckoningModel))
+        reckoning.model = reckoningModel == "cv" ? DeadReckoning::ConstantVelocity : DeadReckoning::ConstantAcceleration;
+    arguments.read("--dr-converge", reckoning.convergeTime);
+    arguments.read("--dr-threshold", sendThreshold);
+    reckoning.sharedClock = generateCount > 0;
+
     const std::string trajFile = "/home/murate/Documents/SwTrn/OsgTrn/osgtrn054/trajectory.txt";
-    generateTrajectoryFile(trajFile);
-    TrajData data = loadTrajectoryFile(trajFile);
+    generateTrajectoryFile(trajFile, offset);
+    const std::string trailFile = trajFile.substr(0, trajFile.find_last_of('.')) + ".trails";
+
+    // Without --scenario, the built-in one is written out (as a template
+    // for new scenarios) and read back like any other
+    if (scenarioFile.empty())
+    {
+        scenarioFile = trajFile.substr(0, trajFile.find_last_of('.')) + ".scenario";
+        const std::string dataPath = "/home/murate/Documents/SwTrn/OsgTrn/OpenSceneGraph-Data/";
+        saveScenario(scenarioFile, defaultScenario(trajFile, dataPath));
+    }
+    Scenario scenario;
+    if (!loadScenario(scenarioFile, scenario))
+        return 1;
+
+    // Everything below the root is placed relative to the floating origin
+    osg::ref_ptr<RenderOrigin> origin = new RenderOrigin(1000.0);
 
     osg::ref_ptr<osg::Group> root = new osg::Group();
     root->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF | osg::StateAttribute::OVERRIDE);
 
-    osg::ref_ptr<Trail> trailF14 = new Trail(2000, 0.15f);
-    osg::ref_ptr<Trail> trailMissile = new Trail(1500, 0.15f);
-
-    // Missile trail red
+    ScenarioScene scene;
+    if (!scene.build(scenario, origin.get()))
     {
-        osg::StateSet *ss = trailMissile->geode()->getOrCreateStateSet();
-        osg::ref_ptr<osg::Vec4Array> col = new osg::Vec4Array;
-        col->push_back(osg::Vec4(1.0f, 0.2f, 0.2f, 1.0f));
-        osg::Geometry *geom = dynamic_cast<osg::Geometry *>(trailMissile->geode()->getDrawable(0));
-        geom->setColorArray(col, osg::Array::BIND_OVERALL);
+        std::cerr << "Scenario " << scenarioFile << " has no usable entities\n";
+        return 1;
     }
+    root->addChild(scene.entities);
 
-    root->addChild(trailF14->geode());
-    root->addChild(trailMissile->geode());
-
-    const std::string dataPath = "/home/murate/Documents/SwTrn/OsgTrn/OpenSceneGraph-Data/";
-    osg::ref_ptr<osg::Node> f14 = osgDB::readRefNodeFile(dataPath + "F-14-low-poly-no-land-gear.ac");
-    osg::ref_ptr<osg::Node> missile = osgDB::readRefNodeFile(dataPath + "AIM-9L.ac");
+    osg::ref_ptr<LiveFeed> feed;
+    LiveFeedGenerator generator;
+    if (feedPort > 0)
+    {
+        feed = new LiveFeed;
+        const SceneModel *fighter = scene.firstModel(ScenarioModel::F14);
+        const SceneModel *missile = scene.firstModel(ScenarioModel::Missile);
+        if (!fighter || !missile)
+        {
+            std::cerr << "Live entities need an f14 and a missile model in the scenario\n";
+            feed = nullptr;
+        }
+        else if (feed->open(static_cast<uint16_t>(feedPort)))
+        {
+            osg::ref_ptr<osg::Group> live = new osg::Group;
+            live->addUpdateCallback(new LiveEntitiesCB(feed.get(), origin.get(), *fighter, *missile, reckoning));
+            root->addChild(live);
+            if (generateCount > 0)
+            {
+                generator.setThresholds(sendThreshold, reckoning.model);
+                generator.start(static_cast<uint16_t>(feedPort), generateCount, offset);
+            }
+        }
+        else
+            feed = nullptr;
+    }
 
-    osg::ref_ptr<osg::MatrixTransform> air = new osg::MatrixTransform;
-    air->addChild(f14);
-    osg::ref_ptr<osg::MatrixTransform> mis = new osg::MatrixTransform;
-    mis->addChild(missile);
-    air->addUpdateCallback(new F14CB(air.get(), trailF14.get(), &data));
-    mis->addUpdateCallback(new MissileCB(mis.get(), trailMissile.get(), &data));
-    root->addChild(air);
-    root->addChild(mis);
+    // Inputs are applied on the root, ahead of the entity callbacks
+    osg::ref_ptr<InputRecorder> input = new InputRecorder(
+        [&](const InputEvent &e)
+        { applyInput(e, scene.trails, trailFile); });
+    if (replayFile.empty() || !input->startReplay(replayFile))
+        input->startRecording(static_cast<uint32_t>(std::time(nullptr)));
+    std::srand(input->seed());
+    root->addUpdateCallback(new InputRecorder::Callback(input.get()));
 
     osg::ref_ptr<osgGA::NodeTrackerManipulator> man = new osgGA::NodeTrackerManipulator;
     man->setTrackerMode(osgGA::NodeTrackerManipulator::NODE_CENTER);
-    man->setTrackNode(f14);
-    man->setHomePosition(osg::Vec3d(-100, 0, -25), osg::Vec3d(0, 0, 0), osg::Vec3d(0, 0, -1));
+    man->setTrackNode(scene.tracked.get());
+    man->setHomePosition(scenario.camera.eye, scenario.camera.center, scenario.camera.up);
 
     osgViewer::Viewer viewer;
     viewer.setCameraManipulator(man);
     viewer.apply(new osgViewer::SingleWindow(100, 100, 1000, 700));
     viewer.setSceneData(root);
     viewer.setRealizeOperation(new ImGuiInitOperation);
-    viewer.addEventHandler(new ImGuiControl(trailF14.get(), trailMissile.get()));
+    viewer.addEventHandler(new ImGuiControl(scene.trails, input.get(), feed.get(), trailFile, inputFile));
+    root->addUpdateCallback(new RenderOrigin::Callback(origin.get(), viewer.getCamera()));
+
+    // Replay drives the frame loop with the recorded simulation times
+    viewer.realize();
+    while (!viewer.done() && input->hasReplayFrame())
+        viewer.frame(input->replayFrameTime());
 
     return viewer.run();
 }
\ No newline at end of file